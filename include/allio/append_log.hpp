@@ -0,0 +1,250 @@
+#pragma once
+
+#include <allio/byte_io.hpp>
+#include <allio/dynamic_storage.hpp>
+#include <allio/file_handle.hpp>
+#include <allio/multiplexer.hpp>
+
+#include <unifex/receiver_concepts.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+namespace allio {
+
+// Durable append-only log on a multiplexable file.
+// Appends are coalesced into gather writes at the tail of the log, and each batch of writes is made durable by
+// a single flush. Appends arriving while a batch is being written and flushed form the next batch.
+// An append completes once its data is durable.
+// Appends may be started concurrently if the multiplexer of the file supports concurrent submission.
+class append_log : async_operation_listener
+{
+public:
+	struct init_options
+	{
+		// Offset of the tail of the log, at which the first append is written.
+		file_offset tail = 0;
+
+		// Appends are added to a batch until it reaches either limit. A single append is never split across batches.
+		size_t max_batch_size = 1024 * 1024;
+		size_t max_batch_buffers = 1024;
+
+		// Maximum number of buffers written by a single gather write.
+		size_t max_write_buffers = 1024;
+
+		file_flush_mode flush_mode = file_flush_mode::data;
+	};
+
+	// Append started on the log. The buffers must remain valid until the append completes.
+	class append_operation
+	{
+		append_operation* m_next = nullptr;
+		detail::untyped_buffers_storage m_buffers;
+		size_t m_size;
+		file_offset m_offset = 0;
+		void(*m_complete)(append_operation& operation, result<file_offset> offset);
+
+	protected:
+		// The completion is invoked with the offset at which the data was written, once the data is durable.
+		append_operation(detail::untyped_buffers_storage const& buffers, void(*const complete)(append_operation& operation, result<file_offset> offset))
+			: m_buffers(buffers)
+			, m_size(0)
+			, m_complete(complete)
+		{
+			for (untyped_buffer const buffer : buffers.buffers())
+			{
+				m_size += buffer.size();
+			}
+		}
+
+		append_operation(append_operation const&) = delete;
+		append_operation& operator=(append_operation const&) = delete;
+		~append_operation() = default;
+
+		friend class append_log;
+	};
+
+private:
+	template<typename Receiver>
+	class operation : append_operation
+	{
+		append_log* m_log;
+		Receiver m_receiver;
+
+	public:
+		operation(append_log& log, detail::untyped_buffers_storage const& buffers, Receiver&& receiver)
+			: append_operation(buffers, complete)
+			, m_log(&log)
+			, m_receiver(static_cast<Receiver&&>(receiver))
+		{
+		}
+
+		void start() & noexcept
+		{
+			m_log->append(*this);
+		}
+
+	private:
+		static void complete(append_operation& operation, result<file_offset> const offset)
+		{
+			auto& self = static_cast<append_log::operation<Receiver>&>(operation);
+
+			if (offset)
+			{
+				unifex::set_value(static_cast<Receiver&&>(self.m_receiver), *offset);
+			}
+			else if constexpr (requires { unifex::set_error(static_cast<Receiver&&>(self.m_receiver), offset.error()); })
+			{
+				unifex::set_error(static_cast<Receiver&&>(self.m_receiver), offset.error());
+			}
+			else
+			{
+				unifex::set_error(static_cast<Receiver&&>(self.m_receiver), std::make_exception_ptr(std::system_error(offset.error(), "append_log")));
+			}
+		}
+	};
+
+	class sender
+	{
+		append_log* m_log;
+		detail::untyped_buffers_storage m_buffers;
+
+	public:
+		static constexpr bool sends_done = false;
+
+		template<template<typename...> typename Variant, template<typename...> typename Tuple>
+		using value_types = Variant<Tuple<file_offset>>;
+
+		template<template<typename...> typename Variant>
+		using error_types = Variant<std::error_code>;
+
+		sender(append_log& log, detail::untyped_buffers_storage const& buffers)
+			: m_log(&log)
+			, m_buffers(buffers)
+		{
+		}
+
+		template<typename Receiver>
+		operation<std::remove_cvref_t<Receiver>> connect(Receiver&& receiver) const noexcept
+		{
+			return { *m_log, m_buffers, static_cast<Receiver&&>(receiver) };
+		}
+	};
+
+	struct operation_list
+	{
+		append_operation* head = nullptr;
+		append_operation* tail = nullptr;
+
+		bool empty() const
+		{
+			return head == nullptr;
+		}
+
+		void push(append_operation& operation);
+		append_operation& pop();
+	};
+
+	enum class flush_state : uint8_t
+	{
+		none,
+		started,
+		succeeded,
+		cancelled,
+		failed,
+	};
+
+	file_handle* m_file;
+	multiplexer* m_multiplexer;
+	init_options m_options;
+
+	mutable std::mutex m_mutex;
+	operation_list m_pending;
+	file_offset m_tail;
+
+	// Set while a batch is in progress. Only the thread driving the batch accesses the batch state.
+	bool m_busy = false;
+
+	// Once a write or flush fails, the tail is unknown and all further appends fail.
+	std::error_code m_error;
+
+	// State of the batch in progress.
+	operation_list m_batch;
+	std::vector<write_buffer> m_batch_buffers;
+	size_t m_batch_buffer_index = 0;
+	file_offset m_write_offset = 0;
+	file_offset m_batch_end = 0;
+
+	// Write and flush in progress, started together in a chain when the multiplexer supports it.
+	// The count includes a reference held while starting them, so that they cannot conclude the round early.
+	std::atomic<uint32_t> m_operation_count = 0;
+	async_operation* m_write_operation = nullptr;
+	async_operation* m_flush_operation = nullptr;
+	dynamic_storage m_write_storage;
+	dynamic_storage m_flush_storage;
+	io::result_storage<size_t> m_write_result;
+	io::result_storage<file_offset> m_flush_result;
+	bool m_write_started = false;
+	bool m_chained = false;
+	std::error_code m_write_error;
+	std::error_code m_flush_error;
+	flush_state m_flush_state = flush_state::none;
+
+public:
+	// The file must be multiplexable and remain valid until all appends have completed.
+	static result<std::unique_ptr<append_log>> create(file_handle& file, init_options const& options);
+
+	append_log(append_log const&) = delete;
+	append_log& operator=(append_log const&) = delete;
+
+	// All appends must have completed. The log must not be destroyed by the completion of an append.
+	~append_log();
+
+
+	// Offset of the end of the durable data, at which the next batch is written.
+	file_offset get_tail() const;
+
+	// Start an append. The completion of the operation may be invoked before this returns.
+	void append(append_operation& operation);
+
+	// Append the data, sending the offset at which it was written once it is durable.
+	sender append_async(write_buffer const buffer)
+	{
+		return { *this, buffer };
+	}
+
+	sender append_async(write_buffers const buffers)
+	{
+		return { *this, as_untyped_buffers(buffers) };
+	}
+
+private:
+	append_log(file_handle& file, init_options const& options);
+
+	// Take the pending appends into a new batch. Returns false if there were none.
+	bool take_batch();
+
+	// Start rounds of operations until one is left in progress, or until no batch remains.
+	void run();
+
+	// Start writing the remainder of the batch, and flushing it once all of it has been written.
+	void start_operations();
+	result<void> start_write(size_t buffer_count);
+	result<void> start_flush();
+
+	// Returns true if the operations of the round have all concluded.
+	bool release_operation();
+
+	// Returns true if another round of operations is to be started, either for the same batch or for the next one.
+	bool operations_concluded();
+
+	// Complete the appends of the batch. Returns true if the next batch was taken.
+	bool complete_batch(std::error_code error);
+
+	void concluded(async_operation& operation) override;
+};
+
+} // namespace allio
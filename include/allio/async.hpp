@@ -5,9 +5,13 @@
 #include <allio/handle.hpp>
 #include <allio/multiplexer.hpp>
 
+#include <unifex/get_stop_token.hpp>
 #include <unifex/sender_concepts.hpp>
 #include <unifex/receiver_concepts.hpp>
+#include <unifex/when_all.hpp>
 
+#include <atomic>
+#include <optional>
 #include <type_traits>
 
 namespace allio {
@@ -105,7 +109,7 @@ class basic_sender
 	};
 
 	size_t m_operation_index;
-	io::parameters_with_handle<Operation> m_args;
+	io::parameters_with_result<Operation> m_args;
 
 public:
 	static constexpr bool sends_done = true;
@@ -124,6 +128,20 @@ public:
 	{
 	}
 
+	// Leave the operation queued until the next explicit submission of the multiplexer.
+	basic_sender&& defer_submission() &&
+	{
+		m_args.defer_submission = true;
+		return static_cast<basic_sender&&>(*this);
+	}
+
+	// Fail the operation with std::errc::timed_out if it has not completed by the deadline.
+	basic_sender&& with_deadline(deadline const deadline) &&
+	{
+		m_args.deadline = deadline;
+		return static_cast<basic_sender&&>(*this);
+	}
+
 	template<typename Receiver>
 	operation<std::remove_cvref_t<Receiver>> connect(Receiver&& receiver) noexcept
 	{
@@ -131,6 +149,226 @@ public:
 	}
 };
 
+// Sender for a multishot operation. Each result produced by the operation is passed to the callback.
+// The sender completes when the operation concludes, either due to an error or due to cancellation.
+// A stop request on the stop token of the receiver cancels the operation.
+template<typename Operation, typename Callback>
+class basic_multishot_sender
+{
+	using handle_type = typename io::parameters<Operation>::handle_type;
+	using result_type = typename io::parameters<Operation>::result_type;
+
+	template<typename Receiver>
+	class operation
+		: async_operation_listener
+		, io::result_storage<result_type>
+	{
+		struct stop_callback
+		{
+			operation* self;
+
+			void operator()() noexcept
+			{
+				self->request_stop();
+			}
+		};
+
+		using stop_token_type = unifex::stop_token_type_t<Receiver&>;
+		using stop_callback_type = typename stop_token_type::template callback_type<stop_callback>;
+
+		enum class start_state : uint8_t
+		{
+			starting,
+			started,
+			concluded,
+		};
+
+		size_t m_operation_index;
+		io::parameters_with_result<Operation> m_args;
+		Callback m_callback;
+		Receiver m_receiver;
+		small_dynamic_storage<96> m_storage;
+
+		std::optional<stop_callback_type> m_stop_callback;
+		std::atomic<async_operation*> m_operation = nullptr;
+		std::atomic<bool> m_stop_requested = false;
+
+		// The operation may conclude before it has been started. The receiver is then completed by start.
+		std::atomic<start_state> m_start_state = start_state::starting;
+
+	public:
+		operation(basic_multishot_sender&& sender, Receiver&& receiver)
+			: m_operation_index(sender.m_operation_index)
+			, m_args(static_cast<decltype(sender.m_args)&&>(sender.m_args))
+			, m_callback(static_cast<Callback&&>(sender.m_callback))
+			, m_receiver(static_cast<Receiver&&>(receiver))
+		{
+		}
+
+		void start() & noexcept
+		{
+			stop_token_type const stop_token = unifex::get_stop_token(m_receiver);
+
+			if (stop_token.stop_requested())
+			{
+				unifex::set_done(static_cast<Receiver&&>(m_receiver));
+				return;
+			}
+
+			// The callback is invoked immediately if stop is requested before this point.
+			m_stop_callback.emplace(stop_token, stop_callback{ this });
+
+			m_args.bind_storage(*this);
+			multiplexer_handle_relation const& relation = m_args.handle->get_multiplexer_relation();
+			auto const result = m_args.handle->get_multiplexer()->construct_and_start(
+				relation.operations[m_operation_index], m_storage.get(relation.operation_storage_requirements), m_args, this);
+			if (!result)
+			{
+				m_stop_callback.reset();
+				set_error(result.error());
+				return;
+			}
+
+			m_operation.store(*result, std::memory_order_release);
+
+			// A stop requested during start did not see the operation.
+			if (m_stop_requested.load(std::memory_order_acquire))
+			{
+				cancel(**result);
+			}
+
+			if (m_start_state.exchange(start_state::started, std::memory_order_acq_rel) == start_state::concluded)
+			{
+				complete(**result);
+			}
+		}
+
+	private:
+		void request_stop() noexcept
+		{
+			m_stop_requested.store(true, std::memory_order_release);
+
+			if (async_operation* const operation = m_operation.load(std::memory_order_acquire))
+			{
+				cancel(*operation);
+			}
+		}
+
+		void cancel(async_operation& operation) noexcept
+		{
+			// If the operation cannot be cancelled, it still concludes eventually.
+			multiplexer_handle_relation const& relation = m_args.handle->get_multiplexer_relation();
+			(void)m_args.handle->get_multiplexer()->cancel(relation.operations[m_operation_index], operation);
+		}
+
+		void yielded(async_operation& operation) override
+		{
+			if (std::error_code const result = operation.get_result())
+			{
+				m_callback(allio::result<result_type>(allio_ERROR(result)));
+			}
+			else
+			{
+				m_callback(allio::result<result_type>(static_cast<result_type&&>(this->result)));
+			}
+		}
+
+		void concluded(async_operation& operation) override
+		{
+			if (m_start_state.exchange(start_state::concluded, std::memory_order_acq_rel) == start_state::starting)
+			{
+				return;
+			}
+
+			complete(operation);
+		}
+
+		void complete(async_operation& operation) noexcept
+		{
+			// Waits for a concurrently running stop callback.
+			m_stop_callback.reset();
+
+			if (std::error_code const result = operation.get_result())
+			{
+				if (operation.is_cancelled())
+				{
+					unifex::set_done(static_cast<Receiver&&>(m_receiver));
+				}
+				else
+				{
+					set_error(result);
+				}
+			}
+			else
+			{
+				// The final result of an operation which stopped without an error.
+				m_callback(allio::result<result_type>(static_cast<result_type&&>(this->result)));
+				unifex::set_value(static_cast<Receiver&&>(m_receiver));
+			}
+		}
+
+		void set_error(std::error_code const result) noexcept
+		{
+			if constexpr (requires { unifex::set_error(static_cast<Receiver&&>(m_receiver), result); })
+			{
+				unifex::set_error(static_cast<Receiver&&>(m_receiver), result);
+			}
+			else
+			{
+				unifex::set_error(static_cast<Receiver&&>(m_receiver), std::make_exception_ptr(std::system_error(result, "basic_multishot_sender")));
+			}
+		}
+	};
+
+	size_t m_operation_index;
+	io::parameters_with_result<Operation> m_args;
+	Callback m_callback;
+
+public:
+	static constexpr bool sends_done = true;
+
+	template<template<typename...> typename Variant, template<typename...> typename Tuple>
+	using value_types = Variant<Tuple<>>;
+
+	template<template<typename...> typename Variant>
+	using error_types = Variant<std::error_code>;
+
+
+	template<typename Handle, typename... Args>
+	basic_multishot_sender(Handle& handle, Callback callback, Args&&... args)
+		: m_operation_index(type_list_index<typename Handle::async_operations, Operation>)
+		, m_args(handle, static_cast<Args&&>(args)...)
+		, m_callback(static_cast<Callback&&>(callback))
+	{
+	}
+
+	// Leave the operation queued until the next explicit submission of the multiplexer.
+	basic_multishot_sender&& defer_submission() &&
+	{
+		m_args.defer_submission = true;
+		return static_cast<basic_multishot_sender&&>(*this);
+	}
+
+	// Fail the operation with std::errc::timed_out if it has not completed by the deadline.
+	basic_multishot_sender&& with_deadline(deadline const deadline) &&
+	{
+		m_args.deadline = deadline;
+		return static_cast<basic_multishot_sender&&>(*this);
+	}
+
+	template<typename Receiver>
+	operation<std::remove_cvref_t<Receiver>> connect(Receiver&& receiver) noexcept
+	{
+		return { static_cast<basic_multishot_sender&&>(*this), static_cast<Receiver&&>(receiver) };
+	}
+};
+
+template<typename Handle>
+basic_sender<io::close> final_handle<Handle>::close_async()
+{
+	return { *this };
+}
+
 
 namespace detail {
 
@@ -386,10 +624,116 @@ struct error_into_except_fn
 	}
 };
 
+
+template<typename Sender>
+class chain_sender
+{
+	template<typename Receiver>
+	class operation
+	{
+		class chain_receiver
+		{
+			operation* m_operation;
+
+		public:
+			explicit chain_receiver(operation* const operation)
+				: m_operation(operation)
+			{
+			}
+
+			void set_value(auto&&... values) &&
+			{
+				unifex::set_value(static_cast<Receiver&&>(m_operation->m_receiver), static_cast<decltype(values)&&>(values)...);
+			}
+
+			template<typename Error>
+			void set_error(Error&& error) && noexcept
+			{
+				if constexpr (requires { unifex::set_error(static_cast<Receiver&&>(m_operation->m_receiver), static_cast<Error&&>(error)); })
+				{
+					unifex::set_error(static_cast<Receiver&&>(m_operation->m_receiver), static_cast<Error&&>(error));
+				}
+				else
+				{
+					unifex::set_error(static_cast<Receiver&&>(m_operation->m_receiver), std::make_exception_ptr(std::system_error(error, "chain_async")));
+				}
+			}
+
+			void set_done() && noexcept
+			{
+				unifex::set_done(static_cast<Receiver&&>(m_operation->m_receiver));
+			}
+		};
+
+		multiplexer* m_multiplexer;
+		chain_mode m_mode;
+		Receiver m_receiver;
+		unifex::connect_result_t<Sender, chain_receiver> m_operation;
+
+	public:
+		operation(chain_sender&& sender, Receiver&& receiver)
+			: m_multiplexer(sender.m_multiplexer)
+			, m_mode(sender.m_mode)
+			, m_receiver(static_cast<Receiver&&>(receiver))
+			, m_operation(unifex::connect(static_cast<Sender&&>(sender.m_sender), chain_receiver(this)))
+		{
+		}
+
+		void start() & noexcept
+		{
+			if (auto const result = m_multiplexer->begin_chain(m_mode); !result)
+			{
+				chain_receiver(this).set_error(result.error());
+				return;
+			}
+
+			unifex::start(m_operation);
+
+			// If the chain cannot be submitted, its operations are concluded with the error.
+			(void)m_multiplexer->end_chain();
+		}
+	};
+
+	multiplexer* m_multiplexer;
+	chain_mode m_mode;
+	Sender m_sender;
+
+public:
+	static constexpr bool sends_done = true;
+
+	template<template<typename...> typename Variant, template<typename...> typename Tuple>
+	using value_types = unifex::sender_value_types_t<Sender, Variant, Tuple>;
+
+	template<template<typename...> typename Variant>
+	using error_types = Variant<std::error_code, std::exception_ptr>;
+
+	chain_sender(multiplexer& multiplexer, chain_mode const mode, Sender&& sender)
+		: m_multiplexer(&multiplexer)
+		, m_mode(mode)
+		, m_sender(static_cast<Sender&&>(sender))
+	{
+	}
+
+	template<typename Receiver>
+	operation<std::remove_cvref_t<Receiver>> connect(Receiver&& receiver) && noexcept
+	{
+		return { static_cast<chain_sender&&>(*this), static_cast<Receiver&&>(receiver) };
+	}
+};
+
 } // namespace detail
 
 inline constexpr detail::result_into_error_fn result_into_error = {};
 inline constexpr detail::error_into_result_fn error_into_result = {};
 inline constexpr detail::error_into_except_fn error_into_except = {};
 
+// Perform the operations in sequence, submitting them to the multiplexer together as a single chain.
+// The values of all operations are sent once the last operation has completed.
+template<typename... Senders>
+auto chain_async(multiplexer& multiplexer, chain_mode const mode, Senders&&... senders)
+{
+	using sender_type = decltype(unifex::when_all(static_cast<Senders&&>(senders)...));
+	return detail::chain_sender<sender_type>(multiplexer, mode, unifex::when_all(static_cast<Senders&&>(senders)...));
+}
+
 } // namespace allio
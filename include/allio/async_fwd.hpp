@@ -5,4 +5,7 @@ namespace allio {
 template<typename Operation>
 class basic_sender;
 
+template<typename Operation, typename Callback>
+class basic_multishot_sender;
+
 } // namespace allio
@@ -1,6 +1,7 @@
 #pragma once
 
 //#include <allio/detail/any_handle.hpp>
+#include <allio/detail/assert.hpp>
 #include <allio/handle.hpp>
 #include <allio/multiplexer.hpp>
 #include <allio/type_list.hpp>
@@ -134,29 +135,128 @@ basic_buffer<const std::byte> as_write_buffer(T const* const data, size_t const
 }
 
 
+// View of memory registered with a multiplexer.
+// Multiplexers supporting buffer registration use the index to avoid mapping
+// the memory for each operation. Other multiplexers treat it as a plain buffer.
+class registered_buffer
+{
+	static constexpr uint32_t invalid_index = static_cast<uint32_t>(-1);
+
+	std::byte* m_data;
+	size_t m_size;
+	uint32_t m_index;
+
+public:
+	registered_buffer()
+		: m_data(nullptr)
+		, m_size(0)
+		, m_index(invalid_index)
+	{
+	}
+
+	registered_buffer(std::byte* const data, size_t const size, uint32_t const index)
+		: m_data(data)
+		, m_size(size)
+		, m_index(index)
+	{
+	}
+
+	std::byte* data() const
+	{
+		return m_data;
+	}
+
+	size_t size() const
+	{
+		return m_size;
+	}
+
+	uint32_t index() const
+	{
+		return m_index;
+	}
+
+	explicit operator bool() const
+	{
+		return m_index != invalid_index;
+	}
+
+	registered_buffer subspan(size_t const offset, size_t const size) const
+	{
+		allio_ASSERT(offset <= m_size && size <= m_size - offset);
+		return registered_buffer(m_data + offset, size, m_index);
+	}
+
+	operator read_buffer() const
+	{
+		return read_buffer(m_data, m_size);
+	}
+
+	operator write_buffer() const
+	{
+		return write_buffer(m_data, m_size);
+	}
+};
+
+
+// Buffer selected by the multiplexer from a group of provided buffers.
+// The buffer is owned by the caller until it is released back to the multiplexer.
+struct provided_buffer
+{
+	std::byte* data = nullptr;
+	size_t size = 0;
+	uint16_t group = 0;
+	uint16_t index = 0;
+
+	explicit operator bool() const
+	{
+		return data != nullptr;
+	}
+};
+
+
 namespace detail {
 
 class untyped_buffers_storage
 {
+	static constexpr uint32_t unregistered = static_cast<uint32_t>(-1);
+
 	bool m_single;
+	uint32_t m_registered_index;
 	untyped_buffer m_buffer;
 
 public:
 	untyped_buffers_storage()
-		: m_single(false)
+		: m_single(false), m_registered_index(unregistered)
 	{
 	}
 
 	untyped_buffers_storage(untyped_buffer const buffer)
-		: m_single(true), m_buffer(buffer)
+		: m_single(true), m_registered_index(unregistered), m_buffer(buffer)
 	{
 	}
 
 	untyped_buffers_storage(untyped_buffers const buffers)
-		: m_single(false), m_buffer(buffers.data(), buffers.size())
+		: m_single(false), m_registered_index(unregistered), m_buffer(buffers.data(), buffers.size())
 	{
 	}
 
+	untyped_buffers_storage(registered_buffer const buffer)
+		: m_single(true), m_registered_index(buffer.index()), m_buffer(buffer.data(), buffer.size())
+	{
+	}
+
+	bool is_registered() const
+	{
+		return m_registered_index != unregistered;
+	}
+
+	uint32_t registered_index() const
+	{
+		allio_ASSERT(is_registered());
+		return m_registered_index;
+	}
+
 	untyped_buffer const* data() const&
 	{
 		return m_single
@@ -210,6 +310,11 @@ struct parameters<scatter_read_at> : scatter_gather_parameters
 		: scatter_gather_parameters{ as_untyped_buffers(buffers), offset }
 	{
 	}
+
+	parameters(file_offset const offset, registered_buffer const buffer)
+		: scatter_gather_parameters{ buffer, offset }
+	{
+	}
 };
 
 template<>
@@ -226,6 +331,11 @@ struct parameters<gather_write_at> : scatter_gather_parameters
 		: scatter_gather_parameters{ as_untyped_buffers(buffers), offset }
 	{
 	}
+
+	parameters(file_offset const offset, registered_buffer const buffer)
+		: scatter_gather_parameters{ buffer, offset }
+	{
+	}
 };
 
 using random_access_scatter_gather = type_list<
@@ -274,6 +384,54 @@ using stream_scatter_gather = type_list<
 	stream_gather_write
 >;
 
+
+// Write without copying the data into kernel buffers.
+// The operation completes only once the kernel no longer references the buffers.
+struct stream_write_zero_copy;
+
+template<>
+struct parameters<stream_write_zero_copy> : scatter_gather_parameters
+{
+	parameters() = default;
+
+	parameters(write_buffer const buffer)
+		: scatter_gather_parameters{ buffer, 0 }
+	{
+	}
+
+	parameters(write_buffers const buffers)
+		: scatter_gather_parameters{ as_untyped_buffers(buffers), 0 }
+	{
+	}
+
+	parameters(registered_buffer const buffer)
+		: scatter_gather_parameters{ buffer, 0 }
+	{
+	}
+};
+
+
+struct stream_read_provided;
+struct multishot_stream_read_provided;
+
+template<>
+struct parameters<stream_read_provided>
+{
+	using handle_type = handle;
+	using result_type = provided_buffer;
+
+	uint16_t buffer_group;
+};
+
+template<>
+struct parameters<multishot_stream_read_provided>
+{
+	using handle_type = handle;
+	using result_type = provided_buffer;
+
+	uint16_t buffer_group;
+};
+
 } // namespace io
 
 
@@ -11,10 +11,35 @@ class deadline
 	// High bit 0: relative
 	// High bit 1: absolute
 	// Low bits: nanoseconds from some epoch or operation start.
+	// All bits set: never.
 	uint64_t m_bits;
 
+	static constexpr uint64_t absolute_bit = static_cast<uint64_t>(1) << 63;
+	static constexpr uint64_t value_mask = absolute_bit - 1;
+	static constexpr uint64_t never_bits = static_cast<uint64_t>(-1);
+
 public:
-	deadline() = default;
+	// Absolute deadlines are measured on this clock.
+	using clock = std::chrono::steady_clock;
+
+	constexpr deadline()
+		: m_bits(never_bits)
+	{
+	}
+
+	// Relative deadline measured from the start of the wait.
+	template<typename Rep, typename Period>
+	constexpr deadline(std::chrono::duration<Rep, Period> const duration)
+		: m_bits(clamp(duration, value_mask))
+	{
+	}
+
+	// Absolute deadline. The largest value is reserved for never.
+	template<typename Duration>
+	constexpr deadline(std::chrono::time_point<clock, Duration> const time_point)
+		: m_bits(absolute_bit | clamp(time_point.time_since_epoch(), value_mask - 1))
+	{
+	}
 
 	static constexpr deadline instant()
 	{
@@ -23,9 +48,51 @@ public:
 
 	static constexpr deadline never()
 	{
-		return deadline(static_cast<uint64_t>(-1));
+		return deadline(never_bits);
+	}
+
+
+	// Never is neither relative nor absolute.
+	constexpr bool is_relative() const
+	{
+		return (m_bits & absolute_bit) == 0;
 	}
 
+	constexpr bool is_absolute() const
+	{
+		return (m_bits & absolute_bit) != 0 && m_bits != never_bits;
+	}
+
+	// Duration of a relative deadline.
+	constexpr std::chrono::nanoseconds relative() const
+	{
+		return std::chrono::nanoseconds(m_bits & value_mask);
+	}
+
+	// Time point of an absolute deadline.
+	constexpr clock::time_point absolute() const
+	{
+		return clock::time_point(std::chrono::duration_cast<clock::duration>(std::chrono::nanoseconds(m_bits & value_mask)));
+	}
+
+	// Time remaining until the deadline, as measured from the specified time.
+	std::chrono::nanoseconds remaining(clock::time_point const now = clock::now()) const
+	{
+		if (m_bits == never_bits)
+		{
+			return std::chrono::nanoseconds::max();
+		}
+
+		if (is_relative())
+		{
+			return relative();
+		}
+
+		std::chrono::nanoseconds const remaining = absolute() - now;
+		return remaining > std::chrono::nanoseconds::zero() ? remaining : std::chrono::nanoseconds::zero();
+	}
+
+
 	bool operator==(deadline const&) const = default;
 
 private:
@@ -33,6 +100,26 @@ private:
 		: m_bits(bits)
 	{
 	}
+
+	// Convert the duration to nanoseconds, saturating at zero and at the maximum.
+	template<typename Rep, typename Period>
+	static constexpr uint64_t clamp(std::chrono::duration<Rep, Period> const duration, uint64_t const max)
+	{
+		// The comparison is performed in floating point, where neither side can overflow.
+		long double const nanoseconds = std::chrono::duration<long double, std::nano>(duration).count();
+
+		if (!(nanoseconds > 0))
+		{
+			return 0;
+		}
+
+		if (nanoseconds >= static_cast<long double>(max))
+		{
+			return max;
+		}
+
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+	}
 };
 
 } // namespace allio
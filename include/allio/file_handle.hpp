@@ -8,6 +8,47 @@
 
 namespace allio {
 
+enum class file_flush_mode : uint8_t
+{
+	// Flush the data and all metadata of the file, like fsync.
+	all,
+
+	// Flush the data and only the metadata needed to read it back, e.g. the size of the file, like fdatasync.
+	data,
+};
+
+struct flush_parameters
+{
+	// Sample the size of the file before flushing, so that the caller can tell which writes the flush made durable.
+	// Sampling costs an extra operation and is not supported for direct descriptors.
+	bool sample_size = false;
+};
+
+enum class file_allocation_mode : uint8_t
+{
+	// Allocate the range, extending the file if the range ends beyond its size.
+	allocate,
+
+	// Allocate the range without changing the size of the file.
+	keep_size,
+
+	// Deallocate the range, which then reads as zeros. The size of the file is not changed.
+	punch_hole,
+
+	// Zero the range without writing the zeros where possible, extending the file if the range ends beyond its size.
+	zero_range,
+};
+
+namespace io {
+
+struct transfer;
+struct flush;
+struct flush_range;
+struct allocate;
+struct set_size;
+
+} // namespace io
+
 namespace detail {
 
 class file_handle_base : public filesystem_handle
@@ -15,7 +56,14 @@ class file_handle_base : public filesystem_handle
 public:
 	using async_operations = type_list_cat<
 		filesystem_handle::async_operations,
-		io::random_access_scatter_gather
+		io::random_access_scatter_gather,
+		type_list<
+			io::transfer,
+			io::flush,
+			io::flush_range,
+			io::allocate,
+			io::set_size
+		>
 	>;
 
 	using filesystem_handle::filesystem_handle;
@@ -37,6 +85,7 @@ public:
 
 	basic_sender<io::scatter_read_at> read_at_async(file_offset offset, read_buffer buffer);
 	basic_sender<io::scatter_read_at> read_at_async(file_offset offset, read_buffers buffers);
+	basic_sender<io::scatter_read_at> read_at_async(file_offset offset, registered_buffer buffer);
 
 	result<size_t> write_at(file_offset offset, write_buffers buffers);
 	result<size_t> write_at(file_offset const offset, write_buffer const buffer)
@@ -46,6 +95,33 @@ public:
 
 	basic_sender<io::gather_write_at> write_at_async(file_offset offset, write_buffer buffer);
 	basic_sender<io::gather_write_at> write_at_async(file_offset offset, write_buffers buffers);
+	basic_sender<io::gather_write_at> write_at_async(file_offset offset, registered_buffer buffer);
+
+	// Transfer bytes starting at the offset to the target handle without copying them through user memory.
+	// Like a write, the transfer may be partial. Returns the number of bytes transferred.
+	result<size_t> transfer_to(file_offset offset, size_t size, platform_handle const& target);
+	basic_sender<io::transfer> transfer_to_async(file_offset offset, size_t size, platform_handle const& target);
+
+	// Make writes to the file durable. If requested, returns the size of the file sampled just before flushing:
+	// writes which completed before the flush was started and end at or below that offset are durable.
+	// Otherwise returns zero.
+	// A flush started in a chain after writes covers those writes, so a write and its flush are submitted together.
+	result<file_offset> flush(file_flush_mode mode = file_flush_mode::all, flush_parameters const& args = {});
+	basic_sender<io::flush> flush_async(file_flush_mode mode = file_flush_mode::all, flush_parameters const& args = {});
+
+	// Write back the data in the range and wait for it, like sync_file_range. Returns the end of the range.
+	// Metadata and the volatile cache of the device are not flushed, so the data is durable only if its blocks
+	// were already allocated and the device has no volatile cache. Where ranges are not supported the whole file is flushed.
+	result<file_offset> flush_range(file_offset offset, uint64_t size);
+	basic_sender<io::flush_range> flush_range_async(file_offset offset, uint64_t size);
+
+	// Allocate or deallocate storage for the range, like fallocate.
+	result<void> allocate(file_allocation_mode mode, file_offset offset, uint64_t size);
+	basic_sender<io::allocate> allocate_async(file_allocation_mode mode, file_offset offset, uint64_t size);
+
+	// Extend or truncate the file to the size. An extension reads as zeros.
+	result<void> set_size(file_offset size);
+	basic_sender<io::set_size> set_size_async(file_offset size);
 
 private:
 	result<void> open(filesystem_handle const* base, path_view path, file_parameters const& args);
@@ -53,6 +129,14 @@ private:
 
 	result<size_t> read_at_sync(file_offset offset, read_buffers buffers);
 	result<size_t> write_at_sync(file_offset offset, write_buffers buffers);
+
+	result<size_t> transfer_to_sync(file_offset offset, size_t size, platform_handle const& target);
+
+	result<file_offset> flush_sync(file_flush_mode mode, flush_parameters const& args);
+	result<file_offset> flush_range_sync(file_offset offset, uint64_t size);
+
+	result<void> allocate_sync(file_allocation_mode mode, file_offset offset, uint64_t size);
+	result<void> set_size_sync(file_offset size);
 };
 
 } // namespace detail
@@ -69,4 +153,56 @@ result<file_handle> open_temporary_file(path_view relative_path, file_parameters
 result<file_handle> open_anonymous_file(file_parameters const& args = {});
 result<file_handle> open_anonymous_file(filesystem_handle const& base, file_parameters const& args = {});
 
+
+template<>
+struct io::parameters<io::transfer>
+{
+	using handle_type = handle;
+	using result_type = size_t;
+
+	file_offset offset;
+	size_t size;
+	platform_handle const* target;
+};
+
+template<>
+struct io::parameters<io::flush>
+{
+	using handle_type = handle;
+	using result_type = file_offset;
+
+	file_flush_mode mode;
+	flush_parameters args;
+};
+
+template<>
+struct io::parameters<io::flush_range>
+{
+	using handle_type = handle;
+	using result_type = file_offset;
+
+	file_offset offset;
+	uint64_t size;
+};
+
+template<>
+struct io::parameters<io::allocate>
+{
+	using handle_type = handle;
+	using result_type = void;
+
+	file_allocation_mode mode;
+	file_offset offset;
+	uint64_t size;
+};
+
+template<>
+struct io::parameters<io::set_size>
+{
+	using handle_type = handle;
+	using result_type = void;
+
+	file_offset size;
+};
+
 } // namespace allio
@@ -62,6 +62,11 @@ inline basic_sender<io::scatter_read_at> detail::file_handle_base::read_at_async
 	return { *this, offset, buffers };
 }
 
+inline basic_sender<io::scatter_read_at> detail::file_handle_base::read_at_async(file_offset const offset, registered_buffer const buffer)
+{
+	return { *this, offset, buffer };
+}
+
 inline basic_sender<io::gather_write_at> detail::file_handle_base::write_at_async(file_offset const offset, write_buffer const buffer)
 {
 	return { *this, offset, buffer };
@@ -72,6 +77,36 @@ inline basic_sender<io::gather_write_at> detail::file_handle_base::write_at_asyn
 	return { *this, offset, buffers };
 }
 
+inline basic_sender<io::gather_write_at> detail::file_handle_base::write_at_async(file_offset const offset, registered_buffer const buffer)
+{
+	return { *this, offset, buffer };
+}
+
+inline basic_sender<io::transfer> detail::file_handle_base::transfer_to_async(file_offset const offset, size_t const size, platform_handle const& target)
+{
+	return { *this, offset, size, &target };
+}
+
+inline basic_sender<io::flush> detail::file_handle_base::flush_async(file_flush_mode const mode, flush_parameters const& args)
+{
+	return { *this, mode, args };
+}
+
+inline basic_sender<io::flush_range> detail::file_handle_base::flush_range_async(file_offset const offset, uint64_t const size)
+{
+	return { *this, offset, size };
+}
+
+inline basic_sender<io::allocate> detail::file_handle_base::allocate_async(file_allocation_mode const mode, file_offset const offset, uint64_t const size)
+{
+	return { *this, mode, offset, size };
+}
+
+inline basic_sender<io::set_size> detail::file_handle_base::set_size_async(file_offset const size)
+{
+	return { *this, size };
+}
+
 
 inline auto open_file_async(multiplexer& multiplexer, path_view const path, file_parameters const& args = {})
 {
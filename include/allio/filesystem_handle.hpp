@@ -31,6 +31,18 @@ enum class file_creation : uint8_t
 
 enum class file_caching : uint8_t
 {
+	// Reads and writes go through the page cache.
+	cached,
+
+	// Writes go through the page cache, but complete only once the data has been written to the storage device.
+	write_through,
+
+	// Reads and writes bypass the page cache, transferring data directly between the buffers and the storage device.
+	// Buffer addresses, file offsets and transfer sizes must be aligned to the logical block size of the device.
+	unbuffered,
+
+	// Unbuffered, and writes complete only once the data has been written to the storage device.
+	unbuffered_write_through,
 };
 
 enum class file_flags : uint32_t
@@ -61,6 +73,10 @@ struct file_parameters
 	file_creation creation = file_creation::open_existing;
 	file_caching caching = {};
 	file_flags flags = {};
+
+	// Space allocated for the file when it is opened, without changing its size.
+	// On Windows it is only allocated when the file is created or overwritten.
+	uint64_t allocation_size = 0;
 };
 
 enum class path_kind : uint32_t
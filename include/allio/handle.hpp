@@ -1,11 +1,14 @@
 #pragma once
 
+#include <allio/async_fwd.hpp>
 #include <allio/detail/assert.hpp>
 #include <allio/detail/flags.hpp>
 #include <allio/detail/linear.hpp>
 #include <allio/multiplexer.hpp>
 #include <allio/type_list.hpp>
 
+#include <utility>
+
 #include <cstdint>
 
 namespace allio {
@@ -14,6 +17,10 @@ enum class flags : uint32_t
 {
 	none                                = 0,
 	multiplexable                       = 1 << 0,
+
+	// The handle is only accessible through its multiplexer, e.g. as an io_uring direct descriptor.
+	// Such a handle cannot be used for synchronous operations and is closed when its multiplexer is changed.
+	multiplexer_bound                   = 1 << 1,
 };
 allio_detail_FLAG_ENUM(flags);
 
@@ -73,6 +80,13 @@ public:
 		return m_multiplexer_data.value;
 	}
 
+	// Take the multiplexer data of the handle. The handle is subsequently released or closed without
+	// deregistering it from its multiplexer, which is left to the caller holding the data.
+	[[nodiscard]] void* take_multiplexer_data()
+	{
+		return std::exchange(m_multiplexer_data.value, nullptr);
+	}
+
 protected:
 	explicit handle(native_handle_type const handle)
 		: m_flags(handle.handle_flags)
@@ -168,6 +182,9 @@ public:
 		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
 	}
 
+	// Close the handle on its multiplexer without blocking, e.g. using IORING_OP_CLOSE.
+	basic_sender<io::close> close_async();
+
 
 	template<typename Operation>
 	async_operation_descriptor const& get_descriptor() const
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <allio/detail/api.hpp>
+#include <allio/detail/assert.hpp>
+#include <allio/linux/detail/unique_fd.hpp>
+#include <allio/linux/platform.hpp>
+#include <allio/multiplexer.hpp>
+#include <allio/platform_handle.hpp>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <allio/linux/detail/undef.i>
+
+namespace allio::linux {
+
+// Readiness based multiplexer for kernels where io_uring is unavailable, e.g. when blocked by seccomp.
+// Socket operations are attempted without blocking and retried when epoll reports the socket ready.
+// File operations, which cannot wait for readiness, are offloaded to a pool of worker threads.
+class epoll_multiplexer final : public multiplexer
+{
+public:
+	class async_operation_storage;
+
+private:
+	using timer_map = std::multimap<deadline::clock::time_point, async_operation_storage*>;
+
+	struct handle_state;
+
+public:
+	// Readiness awaited by an operation which would block.
+	enum class readiness : uint8_t
+	{
+		read,
+		write,
+	};
+
+	class async_operation_storage : public async_operation
+	{
+		async_operation_storage* m_next = nullptr;
+
+		result<void>(*m_perform)(async_operation_storage& storage) = nullptr;
+		std::error_code m_perform_result;
+
+		handle_state* m_handle_state = nullptr;
+		readiness m_readiness = readiness::read;
+
+		deadline m_deadline;
+		std::optional<timer_map::iterator> m_timer;
+
+	public:
+		async_operation_storage(async_operation_parameters const& arguments, async_operation_listener* const listener)
+			: async_operation(listener)
+			, m_deadline(arguments.deadline)
+		{
+		}
+
+		friend class epoll_multiplexer;
+	};
+
+	template<typename Operation>
+	struct basic_async_operation_storage
+		: async_operation_storage
+		, io::parameters_with_result<Operation>
+	{
+		basic_async_operation_storage(io::parameters_with_result<Operation> const& arguments, async_operation_listener* const listener)
+			: async_operation_storage(arguments, listener)
+			, io::parameters_with_result<Operation>(arguments)
+		{
+		}
+	};
+
+private:
+	struct operation_list
+	{
+		async_operation_storage* m_head = nullptr;
+		async_operation_storage* m_tail = nullptr;
+
+		operation_list() = default;
+		operation_list(operation_list const&) = delete;
+		operation_list& operator=(operation_list const&) = delete;
+
+		bool empty() const
+		{
+			return m_head == nullptr;
+		}
+
+		void push(async_operation_storage& storage);
+		void push(operation_list& list);
+		async_operation_storage& pop();
+		bool remove(async_operation_storage& storage);
+	};
+
+	struct handle_state
+	{
+		int fd;
+
+		// The handle was in blocking mode before registration.
+		bool restore_blocking;
+
+		// Operations waiting for read and write readiness, in order of submission.
+		operation_list waiters[2];
+	};
+
+	int m_epoll;
+	int m_event;
+
+	std::optional<std::mutex> m_mutex;
+
+	timer_map m_timers;
+	operation_list m_completion_list;
+
+	// Number of threads currently polling. Deregistered handle states are retired until no thread is polling,
+	// because the polling threads may still be holding events referring to them.
+	uint32_t m_poll_count = 0;
+	std::vector<handle_state*> m_retired_handle_states;
+
+	// Shared by the worker threads and the polling thread.
+	std::mutex m_work_mutex;
+	std::condition_variable m_work_condition;
+	operation_list m_work_list;
+	operation_list m_work_completion_list;
+	bool m_work_stop = false;
+
+	std::vector<std::thread> m_workers;
+
+public:
+	struct init_options
+	{
+		bool enable_concurrent_submission = false;
+		bool enable_concurrent_completion = false;
+
+		// Number of threads performing file operations.
+		// Zero performs file operations synchronously when they are started.
+		uint32_t worker_thread_count = 0;
+	};
+
+	class init_result
+	{
+		detail::unique_fd epoll;
+		detail::unique_fd event;
+		uint32_t worker_thread_count;
+		bool enable_concurrency;
+
+		friend class epoll_multiplexer;
+	};
+
+	static result<init_result> init(init_options const& options);
+
+
+	epoll_multiplexer(init_result&& resources);
+	epoll_multiplexer(epoll_multiplexer const&) = delete;
+	epoll_multiplexer& operator=(epoll_multiplexer const&) = delete;
+	~epoll_multiplexer() override;
+
+
+	type_id<multiplexer> get_type_id() const override;
+
+	result<multiplexer_handle_relation const*> find_handle_relation(type_id<handle> handle_type) const override;
+
+
+	result<void> poll(deadline deadline) override;
+
+
+	// Register a handle for readiness notifications. The handle is switched to non-blocking mode.
+	result<void*> register_native_handle(native_platform_handle handle);
+	result<void> deregister_native_handle(native_platform_handle handle, void* handle_data);
+
+
+	template<std::derived_from<async_operation_storage> Storage = async_operation_storage>
+	using perform_callback = result<void>(Storage& storage);
+
+	// Perform an operation on a registered handle without blocking.
+	// If the operation would block, it is performed again once the handle becomes ready.
+	result<void> push(async_operation_storage& storage, handle const& handle, readiness readiness, perform_callback<>* perform);
+
+	template<std::derived_from<async_operation_storage> Storage>
+	result<void> push(Storage& storage, handle const& handle, readiness const readiness, perform_callback<Storage>* const perform)
+	{
+		return push(static_cast<async_operation_storage&>(storage), handle, readiness, reinterpret_cast<perform_callback<>*>(perform));
+	}
+
+	// Perform a blocking operation on a worker thread.
+	// Deadlines are not applied to blocking operations.
+	result<void> push_work(async_operation_storage& storage, perform_callback<>* perform);
+
+	template<std::derived_from<async_operation_storage> Storage>
+	result<void> push_work(Storage& storage, perform_callback<Storage>* const perform)
+	{
+		return push_work(static_cast<async_operation_storage&>(storage), reinterpret_cast<perform_callback<>*>(perform));
+	}
+
+	void post_synchronous_completion(async_operation_storage& storage, std::error_code result = {});
+
+	// Operations waiting for readiness are cancelled immediately.
+	// Operations already handed to a worker thread run to completion.
+	result<void> cancel(async_operation_storage& storage);
+
+private:
+	static std::unique_lock<std::mutex> lock(std::optional<std::mutex>& mutex);
+
+	static bool would_block(std::error_code const& error);
+
+	void work();
+
+	// Perform waiting operations in order until one would block.
+	void perform_waiters(operation_list& waiters, operation_list& completion_list);
+
+	void complete(async_operation_storage& storage, std::error_code result, operation_list& completion_list);
+	void expire_timers(deadline::clock::time_point now, operation_list& completion_list);
+
+	// Wake up a thread blocked in epoll_wait.
+	void wake_poller();
+
+	static void flush(operation_list& completion_list);
+};
+
+} // namespace allio::linux
+
+allio_API extern allio_TYPE_ID(allio::linux::epoll_multiplexer);
+
+#include <allio/linux/detail/undef.i>
@@ -1,19 +1,26 @@
 #pragma once
 
+#include <allio/byte_io.hpp>
 #include <allio/detail/api.hpp>
 #include <allio/detail/assert.hpp>
 #include <allio/detail/capture.hpp>
 #include <allio/detail/concepts.hpp>
 #include <allio/linux/detail/unique_fd.hpp>
+#include <allio/linux/platform.hpp>
 #include <allio/multiplexer.hpp>
 #include <allio/platform_handle.hpp>
 
 #include <atomic>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <vector>
 
 #include <linux/io_uring.h>
+#include <linux/time_types.h>
 
 #include <allio/linux/detail/undef.i>
 
@@ -24,14 +31,38 @@ class io_uring_multiplexer final : public multiplexer
 public:
 	class alignas(uintptr_t) async_operation_storage : public async_operation
 	{
-		async_operation_storage* m_next_submitted;
 		async_operation_storage* m_next_completed;
 
+		// Operations pushed in a chain are collected until the chain is ended.
+		async_operation_storage* m_next_chained;
+
+		// Intermediate results are delivered after the completion queue has been flushed.
+		// Further completions of the operation are not processed until then.
+		async_operation_storage* m_next_yielded;
+		std::atomic<bool> m_yield_pending = false;
+
+		void(*m_init_sqe)(async_operation_storage& storage, io_uring_sqe& sqe) = nullptr;
+		void(*m_init_link_sqe)(async_operation_storage& storage, io_uring_sqe& sqe) = nullptr;
+		int m_link_result = 0;
+
 		result<void>(*m_capture_result)(async_operation_storage& storage, int result) = nullptr;
+		uint32_t m_cqe_flags = 0;
+		bool m_capture_failure = false;
+		bool m_defer_submission;
+		bool m_cancel_requested = false;
+		bool m_await_notification = false;
+		uint32_t m_completion_worker = any_completion_worker;
+
+		deadline m_deadline;
+		__kernel_timespec m_link_timeout;
 
 	public:
-		async_operation_storage(async_operation_parameters const&, async_operation_listener* const listener)
+		static constexpr uint32_t any_completion_worker = static_cast<uint32_t>(-1);
+
+		async_operation_storage(async_operation_parameters const& arguments, async_operation_listener* const listener)
 			: async_operation(listener)
+			, m_defer_submission(arguments.defer_submission)
+			, m_deadline(arguments.deadline)
 		{
 		}
 
@@ -42,6 +73,41 @@ public:
 			m_capture_result = detail::capture_traits<async_operation_storage, int, decltype(&decltype(callable)::operator())>::callback;
 		}
 
+		// Like capture_result, but the callable is also invoked if the operation fails, with the negated error number.
+		// If the callable succeeds for a failed operation, the operation succeeds. Otherwise the failure is reported as usual.
+		template<typename Callable>
+		void capture_completion(Callable const callable)
+		{
+			capture_result(callable);
+			m_capture_failure = true;
+		}
+
+		// Flags of the completion queue entry, valid during result capture.
+		uint32_t get_cqe_flags() const
+		{
+			return m_cqe_flags;
+		}
+
+		// Result of the entry linked before the operation, valid after completion.
+		int get_link_result() const
+		{
+			return m_link_result;
+		}
+
+		// Conclude the operation only on its notification completion, e.g. for zero copy sends.
+		// The result is captured from the preceding completion.
+		void await_notification()
+		{
+			m_await_notification = true;
+		}
+
+		// Run the completion listener callbacks on the specified completion worker.
+		// The index is taken modulo the number of workers. By default operations are distributed evenly.
+		void set_completion_worker(uint32_t const worker)
+		{
+			m_completion_worker = worker;
+		}
+
 	private:
 		result<void> set_result(int const result)
 		{
@@ -67,6 +133,55 @@ public:
 		}
 	};
 
+	struct message_parameters : async_operation_parameters
+	{
+	};
+
+	// Receives messages posted by other multiplexers.
+	// Each message is passed to the listener as a yielded result. The receiver never completes.
+	class message_receiver : public async_operation_storage
+	{
+		uint32_t m_value = 0;
+		bool m_is_descriptor = false;
+
+	public:
+		explicit message_receiver(async_operation_listener& listener)
+			: async_operation_storage(message_parameters(), &listener)
+		{
+		}
+
+		// Value of the message, or the fixed file slot of a received direct descriptor.
+		uint32_t get_value() const
+		{
+			return m_value;
+		}
+
+		bool is_descriptor() const
+		{
+			return m_is_descriptor;
+		}
+
+		friend class io_uring_multiplexer;
+	};
+
+	// Posts a message to a receiver on another multiplexer.
+	// The operation completes on the posting multiplexer once the message has been delivered.
+	class message_sender : public async_operation_storage
+	{
+		io_uring_multiplexer* m_target = nullptr;
+		message_receiver* m_receiver = nullptr;
+		uint32_t m_value = 0;
+		uint32_t m_descriptor_slot = 0;
+
+	public:
+		explicit message_sender(async_operation_listener* const listener = nullptr)
+			: async_operation_storage(message_parameters(), listener)
+		{
+		}
+
+		friend class io_uring_multiplexer;
+	};
+
 private:
 	struct mmapping_deleter
 	{
@@ -108,6 +223,38 @@ private:
 
 	struct defer_context;
 
+	struct alignas(64) completion_worker
+	{
+		// Stack of completed operations, pushed by the reaping thread and taken whole by the worker.
+		std::atomic<async_operation_storage*> m_head = nullptr;
+
+		// Set while the worker is waiting for completions.
+		std::atomic<bool> m_waiting = false;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+	};
+
+	// Allocator for slots in a kernel resource table.
+	class resource_table
+	{
+		std::unique_ptr<uint32_t[]> m_free_list;
+		uint32_t m_size = 0;
+		uint32_t m_free_count = 0;
+
+	public:
+		resource_table() = default;
+		explicit resource_table(uint32_t size);
+
+		uint32_t size() const
+		{
+			return m_size;
+		}
+
+		result<uint32_t> acquire();
+		void release(uint32_t index);
+	};
+
 	int m_io_uring;
 
 	std::byte* m_sq_mmap_addr;
@@ -119,6 +266,12 @@ private:
 	uint32_t m_flags;
 	uint32_t m_features;
 
+	// Opcodes supported by the kernel, as reported by IORING_REGISTER_PROBE.
+	std::bitset<256> m_supported_opcodes;
+
+	bool m_defer_submission;
+	bool m_lock_free_submission;
+
 	uint32_t* m_sq_k_produce; // Mutated by allio.
 	uint32_t* m_sq_k_consume; // Trails *m_sq_k_produce.
 	uint32_t* m_sq_k_flags;
@@ -133,20 +286,43 @@ private:
 	uint32_t m_sq_size;
 	uint32_t m_cq_size;
 
+	resource_table m_buffer_table;
+	resource_table m_file_table;
+	uint32_t m_direct_file_table_size;
+
+	std::unique_ptr<completion_worker[]> m_completion_workers;
+	uint32_t m_completion_worker_count;
+	uint32_t m_completion_worker_next; // Next worker for operations without affinity. Owned by the reaping thread.
+	std::atomic<uint32_t> m_completion_reap_generation; // Incremented whenever a thread stops reaping.
+
 	size_t m_synchronous_completion_count;
 	defer_list<&async_operation_storage::m_next_completed> m_synchronous_completion_list;
 
+	// Timeout ending a wait on kernels without IORING_FEAT_EXT_ARG.
+	// The kernel may read the timespec after the wait has ended, e.g. when the entry is consumed by the kernel polling
+	// thread, so it is kept until the timeout completes.
+	struct alignas(uintptr_t) enter_timeout
+	{
+		__kernel_timespec timespec;
+		enter_timeout* next;
+	};
+
+	std::vector<std::unique_ptr<enter_timeout>> m_enter_timeouts;
+
 	struct alignas(64) // Exclusive access by the submission thread.
 	{
 		std::optional<std::mutex> m_sq_mutex;
 
 		uint32_t m_sq_cq_available; // Number of free CQEs owned by the submission thread.
+		uint32_t m_sq_cq_overcommit; // Number of CQEs acquired beyond the size of the completion queue.
 
+		// In lock-free submission mode m_sq_acquire and m_sq_release are accessed atomically by all submitting threads,
+		// while m_sq_submit is owned by the thread currently flushing the submission queue.
 		uint32_t m_sq_acquire; // Trails *m_sq_k_consume.
 		uint32_t m_sq_release; // Trails m_sq_acquire.
 		uint32_t m_sq_submit; // Trails m_sq_release.
 
-		defer_list<&async_operation_storage::m_next_submitted> m_submitted_list;
+		enter_timeout* m_sq_enter_timeout_free; // Enter timeouts available for reuse.
 	};
 
 	struct alignas(64) // Exclusive access by the completion thread.
@@ -157,17 +333,76 @@ private:
 	struct alignas(64) // Shared access by both submission and completion threads.
 	{
 		std::atomic<uint32_t> m_cq_cq_available; // Number of free CQEs produced by the completion thread.
+		std::atomic<bool> m_sq_flushing; // Set while a thread is flushing the submission queue in lock-free mode.
+		std::atomic<enter_timeout*> m_cq_enter_timeout_free; // Enter timeouts released by the completion thread.
 	};
 
 public:
 	struct init_options
 	{
 		uint32_t min_submission_queue_size = 0;
+		// The completion queue is sized separately, e.g. for multishot operations producing many completions.
+		// Defaults to twice the submission queue size.
 		uint32_t min_completion_queue_size = 0;
 		bool enable_concurrent_submission = false;
 		bool enable_concurrent_completion = false;
+
+		// Submitting threads reserve and publish submission queue entries using atomics instead of a mutex.
+		// The submission queue is flushed by one thread at a time, on behalf of all submitting threads.
+		// Implies concurrent submission. Requires kernel support for IORING_FEAT_EXT_ARG.
+		bool enable_lock_free_submission = false;
+
+		// Number of completion workers to which completed operations are distributed.
+		// The thread reaping the completion queue hands each operation to a worker, which runs its listener callbacks.
+		// Zero runs the callbacks on the polling thread. Requires concurrent completion.
+		uint32_t completion_worker_count = 0;
+
 		bool enable_kernel_polling_thread = false;
 		io_uring_multiplexer const* share_kernel_polling_thread = nullptr;
+
+		// Pin the kernel polling thread to the specified CPU.
+		// Not applicable when sharing the polling thread of another multiplexer.
+		std::optional<uint32_t> kernel_polling_thread_cpu;
+
+		// Time the kernel polling thread keeps polling an empty submission queue before going to sleep.
+		// Zero leaves the kernel default. Not applicable when sharing the polling thread of another multiplexer.
+		std::chrono::milliseconds kernel_polling_thread_idle_time = {};
+
+		// Only the thread which creates the multiplexer may submit, wait for completions or register resources.
+		// The kernel binds the ring to the creating thread, so the multiplexer cannot be handed over to another thread.
+		// Incompatible with concurrent submission and completion.
+		bool enable_single_issuer = false;
+
+		// Run completion task work only when waiting for completions, rather than interrupting the thread.
+		// Requires the single issuer mode.
+		bool enable_deferred_task_running = false;
+
+		// Run completion task work on the next kernel transition, rather than interrupting the thread.
+		bool enable_cooperative_task_running = false;
+
+		// Let the kernel flag pending task work, so that polling enters the kernel only when needed.
+		// Requires cooperative or deferred task running.
+		bool enable_task_running_flag = false;
+
+		// Poll the storage devices for completions instead of waiting for interrupts.
+		// Only reads and writes of files opened unbuffered complete on the multiplexer, and files are opened synchronously.
+		// Operation deadlines and cancellation are not supported, and polling with a deadline spins until the deadline.
+		bool enable_completion_polling = false;
+
+		// Leave pushed operations queued until an explicit submission.
+		// The submission queue is still flushed automatically when it fills up.
+		bool defer_submission = false;
+
+		// Size of the sparse registered buffer table. Zero disables buffer registration.
+		uint32_t buffer_table_size = 0;
+
+		// Size of the sparse fixed file table. Zero disables handle registration.
+		// Handles registered while the table is full fall back to plain file descriptors.
+		uint32_t file_table_size = 0;
+
+		// Number of fixed file slots following the file table, from which the kernel allocates direct descriptors.
+		// Zero disables kernel allocation of direct descriptors.
+		uint32_t direct_file_table_size = 0;
 	};
 
 	class init_result
@@ -177,6 +412,15 @@ public:
 		unique_mmapping sq_ring;
 		unique_mmapping cq_ring;
 		unique_mmapping sqes;
+		resource_table buffer_table;
+		resource_table file_table;
+		uint32_t direct_file_table_size;
+		std::bitset<256> supported_opcodes;
+		bool enable_concurrent_submission;
+		bool enable_concurrent_completion;
+		bool enable_lock_free_submission;
+		uint32_t completion_worker_count;
+		bool defer_submission;
 
 		friend class io_uring_multiplexer;
 	};
@@ -199,9 +443,67 @@ public:
 	result<void> poll(deadline deadline) override;
 	result<void> submit_and_poll(deadline deadline) override;
 
+	// Run the listener callbacks of completed operations distributed to the completion worker.
+	// If no other thread is reaping the completion queue, the calling thread reaps it on behalf of all workers.
+	// Returns after running at least one callback or when the deadline is reached.
+	result<void> poll_completion_worker(uint32_t worker, deadline deadline);
+
 
 	result<void*> register_native_handle(native_platform_handle handle);
-	result<void> deregister_native_handle(native_platform_handle handle);
+	result<void> deregister_native_handle(native_platform_handle handle, void* handle_data);
+
+	// Set the file of an SQE operating on the handle.
+	// Handles registered in the fixed file table are referred to by their slot.
+	static void set_file(io_uring_sqe& sqe, platform_handle const& handle)
+	{
+		if (void* const handle_data = handle.get_multiplexer_data())
+		{
+			sqe.fd = static_cast<int>(reinterpret_cast<uintptr_t>(handle_data) - 1);
+			sqe.flags |= IOSQE_FIXED_FILE;
+		}
+		else
+		{
+			sqe.fd = unwrap_handle(handle.get_platform_handle());
+		}
+	}
+
+
+	// Register memory for use in fixed buffer operations.
+	// The memory must remain valid until the buffer is deregistered.
+	result<registered_buffer> register_buffer(std::span<std::byte> memory);
+	result<void> deregister_buffer(registered_buffer buffer);
+
+
+	// Group of buffers provided to the kernel for selection at completion time.
+	class buffer_group
+	{
+		unique_mmapping m_ring;
+		unique_mmapping m_buffers;
+		uint32_t m_buffer_count;
+		uint32_t m_buffer_size;
+		uint16_t m_id;
+		uint16_t m_tail;
+
+	public:
+		uint16_t id() const
+		{
+			return m_id;
+		}
+
+		// Get the buffer selected for an operation from the flags of its completion queue entry.
+		provided_buffer get_buffer(uint32_t cqe_flags, size_t size) const;
+
+		friend class io_uring_multiplexer;
+	};
+
+	// Create a ring of provided buffers. The buffer count must be a power of two.
+	result<uint16_t> create_buffer_group(uint32_t buffer_count, size_t buffer_size);
+	result<void> destroy_buffer_group(uint16_t group);
+
+	result<buffer_group const*> find_buffer_group(uint16_t group);
+
+	// Return a buffer selected by a completed operation to its group.
+	void release_provided_buffer(provided_buffer buffer);
 
 
 	template<std::derived_from<async_operation_storage> Storage = async_operation_storage>
@@ -215,22 +517,170 @@ public:
 		return push(static_cast<async_operation_storage&>(storage), reinterpret_cast<init_sqe_callback<>*>(init_sqe));
 	}
 
+	// Push an operation preceded by a linked entry, e.g. the first half of a splice through a pipe.
+	// The linked entry has no result of its own, but its failure fails the operation.
+	result<void> push(async_operation_storage& storage, init_sqe_callback<>* init_link_sqe, init_sqe_callback<>* init_sqe);
+
+	template<std::derived_from<async_operation_storage> Storage>
+	result<void> push(Storage& storage, init_sqe_callback<Storage>* const init_link_sqe, init_sqe_callback<Storage>* const init_sqe)
+	{
+		return push(static_cast<async_operation_storage&>(storage),
+			reinterpret_cast<init_sqe_callback<>*>(init_link_sqe),
+			reinterpret_cast<init_sqe_callback<>*>(init_sqe));
+	}
+
 	void post_synchronous_completion(async_operation_storage& storage, int result = 0);
 
 	result<void> cancel(async_operation_storage& storage);
 
+
+	result<void> begin_chain(chain_mode mode) override;
+	result<void> end_chain() override;
+
+
+	// Reserve a slot in the fixed file table for a direct descriptor.
+	result<uint32_t> acquire_file_slot();
+	void release_file_slot(uint32_t slot);
+
+	// Release the handle of a direct descriptor without clearing its fixed file slot.
+	// The caller takes over the slot, e.g. to close it using IORING_OP_CLOSE.
+	template<std::derived_from<platform_handle> Handle>
+	static result<uint32_t> release_direct_handle(Handle& handle)
+	{
+		native_platform_handle const native_handle = handle.get_platform_handle();
+		allio_ASSERT(is_direct_handle(native_handle));
+
+		// Without its multiplexer data, releasing the handle does not clear the slot.
+		void* const handle_data = handle.take_multiplexer_data();
+		allio_ASSERT(handle_data != nullptr);
+
+		if (auto const r = handle.release_native_handle(); !r)
+		{
+			auto& multiplexer = static_cast<io_uring_multiplexer&>(*handle.get_multiplexer());
+			(void)multiplexer.deregister_native_handle(native_handle, handle_data);
+			return allio_ERROR(r.error());
+		}
+
+		return unwrap_direct_handle(native_handle);
+	}
+
+	// True if completions are polled from the storage devices, e.g. using IORING_SETUP_IOPOLL.
+	bool has_completion_polling() const
+	{
+		return (m_flags & IORING_SETUP_IOPOLL) != 0;
+	}
+
+	// True if the kernel supports the opcode. Operations using opcodes added by newer kernels check this
+	// and fall back to synchronous system calls. Kernels without IORING_REGISTER_PROBE support none of these.
+	bool supports_opcode(uint8_t const opcode) const
+	{
+		return m_supported_opcodes.test(opcode);
+	}
+
+	// True if the kernel allocates slots for direct descriptors, e.g. using IORING_FILE_INDEX_ALLOC.
+	bool has_direct_file_allocation() const
+	{
+		return m_direct_file_table_size != 0;
+	}
+
+	// Post a value to a receiver on the target multiplexer.
+	// Messages do not count against the completion queue of the target, which relies on IORING_FEAT_NODROP.
+	result<void> post_message(message_sender& sender, io_uring_multiplexer& target, message_receiver& receiver, uint32_t value);
+
+	// Post a duplicate of a direct descriptor, or of a handle registered in the fixed file table, to the target multiplexer.
+	// The target must allocate direct descriptors. The handle itself remains valid.
+	result<void> post_descriptor(message_sender& sender, io_uring_multiplexer& target, message_receiver& receiver, platform_handle const& handle);
+
+	// True if operations pushed by the calling thread are collected into a chain.
+	bool is_chaining() const
+	{
+		return s_chain.multiplexer == this;
+	}
+
+
+	// Pipe used to splice between two handles, neither of which is a pipe.
+	struct splice_pipe
+	{
+		int read_fd;
+		int write_fd;
+		uint32_t capacity;
+	};
+
+	result<splice_pipe> acquire_splice_pipe();
+
+	// Return an empty pipe to the multiplexer for reuse.
+	// A pipe which may still contain data is closed instead.
+	void release_splice_pipe(splice_pipe pipe, bool empty);
+
 private:
+	struct chain_context
+	{
+		io_uring_multiplexer* multiplexer = nullptr;
+		chain_mode mode = chain_mode::link;
+		uint32_t sqe_count = 0;
+		defer_list<&async_operation_storage::m_next_chained> operations;
+	};
+
+	static thread_local chain_context s_chain;
+
+	std::vector<std::unique_ptr<buffer_group>> m_buffer_groups;
+	std::vector<splice_pipe> m_splice_pipes;
+
 	static std::unique_lock<std::mutex> lock(std::optional<std::mutex>& mutex);
 
+	static void release_provided_buffer(buffer_group& group, uint16_t index);
+
 	io_uring_sqe& use_sqe(uint32_t sqe_index);
 
 	result<uint32_t> acquire_sqe();
+	result<uint32_t> acquire_sqe(defer_context& defer_context);
+	void unacquire_sqe();
 	void release_sqe(uint32_t sqe_index);
 
 	result<void> acquire_cqe();
+	void unacquire_cqe();
 	void release_cqe();
 
-	result<void> push_internal(async_operation_storage& storage, auto&& init_sqe);
+	enter_timeout* acquire_enter_timeout();
+	void release_enter_timeout(enter_timeout* timeout);
+
+	// Reserve consecutive submission queue entries in lock-free mode.
+	// Returns the position of the first entry in the submission ring.
+	result<uint32_t> reserve_sqes(uint32_t count);
+	result<uint32_t> reserve_sqes(defer_context& defer_context, uint32_t count);
+
+	// Publish reserved entries in lock-free mode, after those reserved before them have been published.
+	void publish_sqes(uint32_t position, uint32_t count);
+
+	// Submit published entries in lock-free mode, unless another thread is already doing so.
+	result<void> flush_lock_free_submissions(defer_context& defer_context);
+
+	// Hand the completed operations to the completion workers.
+	void distribute_completions(defer_context& defer_context);
+
+	// Run the listener callbacks of operations distributed to the worker. Returns false if there were none.
+	static bool run_completions(completion_worker& worker);
+
+	// Wake the completion workers waiting for completions after the reaping thread has stopped reaping.
+	void notify_completion_workers();
+
+	// Maximum number of entries pushed at once, e.g. by a chain.
+	static constexpr uint32_t max_push_sqe_count = 64;
+
+	result<void> push_internal(bool submit, uint32_t sqe_count, auto&& init_sqe);
+
+	// Number of entries pushed for the operation, including its linked entry and timeout.
+	static uint32_t get_sqe_count(async_operation_storage const& storage);
+
+	void init_entry_sqe(async_operation_storage& storage, uint32_t index, io_uring_sqe& sqe, uint8_t link_flags);
+	void init_operation_sqe(async_operation_storage& storage, io_uring_sqe& sqe, uint8_t link_flags);
+	static void init_link_timeout_sqe(async_operation_storage& storage, io_uring_sqe& sqe, uint8_t link_flags);
+
+	// True if the kernel has flagged task work which runs only when entering the kernel.
+	bool has_pending_task_work() const;
+
+	// True if the kernel is holding completions which did not fit in the completion queue.
+	bool has_completion_overflow() const;
 
 	uint32_t flush_submission_queue(defer_context& defer_context);
 	uint32_t flush_completion_queue(defer_context& defer_context);
@@ -238,6 +688,32 @@ private:
 	result<void> enter(defer_context& defer_context, bool submit, bool complete, deadline deadline);
 };
 
+// Group of multiplexers sharing the kernel polling thread of a primary multiplexer owned by the group.
+// The polling thread lives until the last multiplexer attached to it is destroyed.
+class io_uring_polling_group
+{
+	std::unique_ptr<io_uring_multiplexer> m_primary;
+
+public:
+	// Create the primary multiplexer. The kernel polling thread is always enabled.
+	static result<io_uring_polling_group> create(io_uring_multiplexer::init_options const& options);
+
+	io_uring_multiplexer& get_primary() const
+	{
+		return *m_primary;
+	}
+
+	// Create a multiplexer attached to the kernel polling thread of the primary multiplexer.
+	// The polling thread options are taken from the primary multiplexer and must not be specified.
+	result<std::unique_ptr<io_uring_multiplexer>> attach(io_uring_multiplexer::init_options const& options) const;
+
+private:
+	explicit io_uring_polling_group(std::unique_ptr<io_uring_multiplexer> primary)
+		: m_primary(std::move(primary))
+	{
+	}
+};
+
 } // namespace allio::linux
 
 allio_API extern allio_TYPE_ID(allio::linux::io_uring_multiplexer);
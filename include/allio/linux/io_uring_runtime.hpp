@@ -0,0 +1,215 @@
+#pragma once
+
+#include <allio/linux/io_uring_multiplexer.hpp>
+#include <allio/socket_handle.hpp>
+
+#include <unifex/receiver_concepts.hpp>
+#include <unifex/sequence.hpp>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <allio/linux/detail/undef.i>
+
+namespace allio::linux {
+
+// Shared-nothing runtime running one thread per core, each owning its own multiplexer.
+// Nothing is shared between the threads. Work is moved to the thread of a core by scheduling it there.
+class io_uring_runtime
+{
+	struct core;
+
+public:
+	// Work posted to the thread of a core.
+	class task
+	{
+		task* m_next = nullptr;
+		void(*m_execute)(task& task, bool stopped);
+
+	protected:
+		// The task is executed as stopped if the runtime stops before the task is executed.
+		explicit task(void(*const execute)(task& task, bool stopped))
+			: m_execute(execute)
+		{
+		}
+
+		task(task const&) = delete;
+		task& operator=(task const&) = delete;
+		~task() = default;
+
+		friend class io_uring_runtime;
+	};
+
+	// Unifex scheduler for the thread of a core.
+	class scheduler
+	{
+		io_uring_runtime* m_runtime;
+		uint32_t m_core;
+
+		template<typename Receiver>
+		class operation : task
+		{
+			io_uring_runtime* m_runtime;
+			uint32_t m_core;
+			Receiver m_receiver;
+
+		public:
+			operation(io_uring_runtime& runtime, uint32_t const core, Receiver&& receiver)
+				: task(execute)
+				, m_runtime(&runtime)
+				, m_core(core)
+				, m_receiver(static_cast<Receiver&&>(receiver))
+			{
+			}
+
+			void start() & noexcept
+			{
+				if (!m_runtime->post(m_core, *this))
+				{
+					unifex::set_done(static_cast<Receiver&&>(m_receiver));
+				}
+			}
+
+		private:
+			static void execute(task& task, bool const stopped)
+			{
+				operation& self = static_cast<operation&>(task);
+
+				if (stopped)
+				{
+					unifex::set_done(static_cast<Receiver&&>(self.m_receiver));
+				}
+				else
+				{
+					unifex::set_value(static_cast<Receiver&&>(self.m_receiver));
+				}
+			}
+		};
+
+		class sender
+		{
+			io_uring_runtime* m_runtime;
+			uint32_t m_core;
+
+		public:
+			static constexpr bool sends_done = true;
+
+			template<template<typename...> typename Variant, template<typename...> typename Tuple>
+			using value_types = Variant<Tuple<>>;
+
+			template<template<typename...> typename Variant>
+			using error_types = Variant<>;
+
+			sender(io_uring_runtime& runtime, uint32_t const core)
+				: m_runtime(&runtime)
+				, m_core(core)
+			{
+			}
+
+			template<typename Receiver>
+			operation<std::remove_cvref_t<Receiver>> connect(Receiver&& receiver) const noexcept
+			{
+				return { *m_runtime, m_core, static_cast<Receiver&&>(receiver) };
+			}
+		};
+
+	public:
+		scheduler(io_uring_runtime& runtime, uint32_t const core)
+			: m_runtime(&runtime)
+			, m_core(core)
+		{
+		}
+
+		sender schedule() const
+		{
+			return { *m_runtime, m_core };
+		}
+
+		friend bool operator==(scheduler const& a, scheduler const& b) = default;
+	};
+
+	struct init_options
+	{
+		// CPUs on which to run the threads, one thread per CPU.
+		// Empty uses every CPU on which the process is allowed to run.
+		std::vector<uint32_t> cpus;
+
+		// Pin each thread to its CPU.
+		bool enable_thread_affinity = true;
+
+		// Options of the multiplexer of each core.
+		// Each multiplexer is created on the thread which uses it, so the single issuer mode may be enabled.
+		io_uring_multiplexer::init_options multiplexer_options;
+	};
+
+	// Start the threads. Returns once the multiplexers of all cores have been created.
+	static result<std::unique_ptr<io_uring_runtime>> create(init_options const& options);
+
+	io_uring_runtime(io_uring_runtime const&) = delete;
+	io_uring_runtime& operator=(io_uring_runtime const&) = delete;
+
+	// Stop and join the threads. Tasks which were not yet executed are executed as stopped.
+	~io_uring_runtime();
+
+
+	uint32_t get_core_count() const
+	{
+		return static_cast<uint32_t>(m_cores.size());
+	}
+
+	// CPU on which the thread of the core runs.
+	uint32_t get_cpu(uint32_t core) const;
+
+	// Multiplexer of the core. It may only be used on the thread of the core.
+	io_uring_multiplexer& get_multiplexer(uint32_t core) const;
+
+	scheduler get_scheduler(uint32_t const core)
+	{
+		allio_ASSERT(core < m_cores.size());
+		return { *this, core };
+	}
+
+	// Run the sender on the thread of the core. The sender is started on that thread.
+	template<typename Sender>
+	auto on(uint32_t const core, Sender&& sender)
+	{
+		return unifex::sequence(get_scheduler(core).schedule(), static_cast<Sender&&>(sender));
+	}
+
+
+	// Post a task to the thread of the core.
+	// Returns false if the runtime is stopping, in which case the task is not executed.
+	bool post(uint32_t core, task& task);
+
+	// Make the threads stop. Posting further tasks fails.
+	void stop();
+
+
+	// Runtime and core of the calling thread, if it belongs to a runtime.
+	static io_uring_runtime* get_current_runtime();
+	static std::optional<uint32_t> get_current_core();
+
+	// Create a listening socket on the multiplexer of the calling core.
+	// Each core may listen on the same address, in which case the kernel distributes incoming connections among them.
+	static result<listen_socket_handle> listen(network_address const& address, listen_parameters const& args = {}, socket_parameters const& create_args = {});
+
+private:
+	std::vector<std::unique_ptr<core>> m_cores;
+	std::atomic<bool> m_stop = false;
+
+	static thread_local core* s_current;
+
+	io_uring_runtime() = default;
+
+	void run(core& core);
+	void wake(core& core);
+
+	// Execute the tasks posted to the core. Returns false if there were none.
+	static bool execute_tasks(core& core, bool stopped);
+};
+
+} // namespace allio::linux
+
+#include <allio/linux/detail/undef.i>
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <allio/detail/platform.hpp>
+#include <allio/platform_handle.hpp>
+
+#include <cstdint>
 
 #include <allio/linux/detail/undef.i>
 
@@ -16,6 +19,23 @@ inline int unwrap_handle(native_platform_handle const handle)
 	return static_cast<int>(static_cast<uintptr_t>(handle) - 1);
 }
 
+// Direct descriptors refer to a slot in an io_uring fixed file table instead of a file descriptor.
+// The slot is stored in the high bits, so that unwrapping a direct descriptor as a file descriptor yields -1.
+inline native_platform_handle wrap_direct_handle(uint32_t const slot)
+{
+	return static_cast<native_platform_handle>((static_cast<uintptr_t>(slot) + 1) << 32);
+}
+
+inline bool is_direct_handle(native_platform_handle const handle)
+{
+	return (static_cast<uintptr_t>(handle) >> 32) != 0;
+}
+
+inline uint32_t unwrap_direct_handle(native_platform_handle const handle)
+{
+	return static_cast<uint32_t>((static_cast<uintptr_t>(handle) >> 32) - 1);
+}
+
 template<typename T>
 inline native_platform_handle wrap_handle(T* const handle)
 {
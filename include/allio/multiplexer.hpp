@@ -20,6 +20,16 @@ class multiplexer;
 
 class async_operation_parameters
 {
+public:
+	// Leave the operation queued in the multiplexer until the next explicit submission.
+	// Multiplexers without a submission queue ignore this.
+	bool defer_submission = false;
+
+	// The operation fails with std::errc::timed_out if it has not completed by the deadline.
+	// Relative deadlines are measured from the start of the operation.
+	// Multiplexers without deadline support fail to start the operation with std::errc::not_supported.
+	allio::deadline deadline;
+
 protected:
 	async_operation_parameters() = default;
 	async_operation_parameters(async_operation_parameters const&) = default;
@@ -55,6 +65,11 @@ class async_operation_listener
 {
 public:
 	virtual void submitted(async_operation& operation) {}
+
+	// Invoked when a multishot operation produces an intermediate result and remains armed.
+	// The result is only valid for the duration of the call.
+	virtual void yielded(async_operation& operation) {}
+
 	virtual void completed(async_operation& operation) {}
 	virtual void concluded(async_operation& operation) {}
 };
@@ -149,6 +164,15 @@ protected:
 	friend class multiplexer;
 };
 
+enum class chain_mode : uint8_t
+{
+	// A failed operation cancels the remaining operations in the chain.
+	link,
+
+	// The remaining operations are performed regardless of failures.
+	hard_link,
+};
+
 struct async_operation_descriptor
 {
 	bool synchronous;
@@ -197,6 +221,11 @@ public:
 	virtual result<async_operation*> construct_and_start(async_operation_descriptor const& descriptor, storage_ptr storage, async_operation_parameters const& arguments, async_operation_listener* listener = nullptr);
 	virtual result<void> cancel(async_operation_descriptor const& descriptor, async_operation& operation);
 
+	// Operations started by the calling thread between begin_chain and end_chain are performed in sequence.
+	// Operations started in the chain are submitted together by end_chain.
+	virtual result<void> begin_chain(chain_mode mode);
+	virtual result<void> end_chain();
+
 	virtual result<void> submit(deadline deadline = {});
 	virtual result<void> poll(deadline deadline = {}) = 0;
 	virtual result<void> submit_and_poll(deadline deadline = {});
@@ -20,6 +20,9 @@ struct socket_parameters
 struct listen_parameters
 {
 	uint32_t backlog = 0;
+
+	// Let multiple sockets listen on the same address, with incoming connections distributed among them.
+	bool reuse_port = false;
 };
 
 struct accept_result;
@@ -30,6 +33,7 @@ struct socket;
 struct connect;
 struct listen;
 struct accept;
+struct multishot_accept;
 
 } // namespace io
 
@@ -61,7 +65,12 @@ public:
 	using async_operations = type_list_cat<
 		common_socket_handle_base::async_operations,
 		type_list<io::connect>,
-		io::stream_scatter_gather
+		io::stream_scatter_gather,
+		type_list<
+			io::stream_write_zero_copy,
+			io::stream_read_provided,
+			io::multishot_stream_read_provided
+		>
 	>;
 
 	using common_socket_handle_base::common_socket_handle_base;
@@ -87,6 +96,19 @@ public:
 	basic_sender<io::stream_gather_write> write_async(write_buffers buffers);
 	basic_sender<io::stream_gather_write> write_async(write_buffer const buffer);
 
+	// Write without copying the data. The buffers must not be modified until the operation completes.
+	basic_sender<io::stream_write_zero_copy> write_zero_copy_async(write_buffers buffers);
+	basic_sender<io::stream_write_zero_copy> write_zero_copy_async(write_buffer buffer);
+	basic_sender<io::stream_write_zero_copy> write_zero_copy_async(registered_buffer buffer);
+
+	// Read into a buffer selected by the multiplexer from the specified group at completion time.
+	basic_sender<io::stream_read_provided> read_provided_async(uint16_t buffer_group);
+
+	// Read repeatedly into buffers selected from the specified group, passing each buffer to the callback.
+	// An empty buffer signals the end of the stream.
+	template<typename Callback>
+	basic_multishot_sender<io::multishot_stream_read_provided, Callback> multishot_read_provided_async(Callback callback, uint16_t buffer_group);
+
 private:
 	result<void> connect_sync(network_address const& address);
 
@@ -101,7 +123,8 @@ public:
 		common_socket_handle_base::async_operations,
 		type_list<
 			io::listen,
-			io::accept
+			io::accept,
+			io::multishot_accept
 		>
 	>;
 
@@ -113,6 +136,10 @@ public:
 	result<accept_result> accept(socket_parameters const& create_args = {}) const;
 	basic_sender<io::accept> accept_async(socket_parameters const& create_args = {}) const;
 
+	// Accept connections until cancelled, passing each accepted socket to the callback.
+	template<typename Callback>
+	basic_multishot_sender<io::multishot_accept, Callback> multishot_accept_async(Callback callback, socket_parameters const& create_args = {}) const;
+
 private:
 	result<void> listen_sync(network_address const& address, listen_parameters const& args);
 	result<accept_result> accept_sync(socket_parameters const& create_args) const;
@@ -177,4 +204,13 @@ struct io::parameters<io::accept>
 	socket_parameters create_args;
 };
 
+template<>
+struct io::parameters<io::multishot_accept>
+{
+	using handle_type = const listen_socket_handle;
+	using result_type = accept_result;
+
+	socket_parameters create_args;
+};
+
 } // namespace allio
@@ -43,6 +43,32 @@ inline basic_sender<io::stream_gather_write> detail::socket_handle_base::write_a
 	return { *this, buffers };
 }
 
+inline basic_sender<io::stream_write_zero_copy> detail::socket_handle_base::write_zero_copy_async(write_buffer const buffer)
+{
+	return { *this, buffer };
+}
+
+inline basic_sender<io::stream_write_zero_copy> detail::socket_handle_base::write_zero_copy_async(write_buffers const buffers)
+{
+	return { *this, buffers };
+}
+
+inline basic_sender<io::stream_write_zero_copy> detail::socket_handle_base::write_zero_copy_async(registered_buffer const buffer)
+{
+	return { *this, buffer };
+}
+
+inline basic_sender<io::stream_read_provided> detail::socket_handle_base::read_provided_async(uint16_t const buffer_group)
+{
+	return { *this, buffer_group };
+}
+
+template<typename Callback>
+basic_multishot_sender<io::multishot_stream_read_provided, Callback> detail::socket_handle_base::multishot_read_provided_async(Callback callback, uint16_t const buffer_group)
+{
+	return { *this, static_cast<Callback&&>(callback), buffer_group };
+}
+
 inline basic_sender<io::listen> detail::listen_socket_handle_base::listen_async(network_address const& address, listen_parameters const& args)
 {
 	return { static_cast<listen_socket_handle&>(*this), address, args };
@@ -55,6 +81,14 @@ inline basic_sender<io::accept> detail::listen_socket_handle_base::accept_async(
 	return { static_cast<listen_socket_handle const&>(*this), create_args_copy };
 }
 
+template<typename Callback>
+basic_multishot_sender<io::multishot_accept, Callback> detail::listen_socket_handle_base::multishot_accept_async(Callback callback, socket_parameters const& create_args) const
+{
+	socket_parameters create_args_copy = create_args;
+	create_args_copy.handle_flags |= flags::multiplexable;
+	return { static_cast<listen_socket_handle const&>(*this), static_cast<Callback&&>(callback), create_args_copy };
+}
+
 
 inline auto connect_async(multiplexer& multiplexer, network_address const& address, socket_parameters const& create_args = {})
 {
@@ -201,6 +201,9 @@ public:
 
 	result<multiplexer_handle_relation const*> find_handle_relation(type_id<handle> handle_type) const override;
 
+	result<async_operation*> construct(async_operation_descriptor const& descriptor, storage_ptr storage, async_operation_parameters const& arguments, async_operation_listener* listener = nullptr) override;
+	result<async_operation*> construct_and_start(async_operation_descriptor const& descriptor, storage_ptr storage, async_operation_parameters const& arguments, async_operation_listener* listener = nullptr) override;
+
 	result<void> submit(deadline deadline) override;
 	result<void> poll(deadline deadline) override;
 	result<void> submit_and_poll(deadline deadline) override;
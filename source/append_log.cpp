@@ -0,0 +1,386 @@
+#include <allio/append_log.hpp>
+
+#include <allio/detail/assert.hpp>
+
+#include <algorithm>
+
+using namespace allio;
+
+void append_log::operation_list::push(append_operation& operation)
+{
+	operation.m_next = nullptr;
+	(head == nullptr ? head : tail->m_next) = &operation;
+	tail = &operation;
+}
+
+append_log::append_operation& append_log::operation_list::pop()
+{
+	allio_ASSERT(head != nullptr);
+	append_operation& operation = *head;
+	if ((head = operation.m_next) == nullptr)
+	{
+		tail = nullptr;
+	}
+	return operation;
+}
+
+result<std::unique_ptr<append_log>> append_log::create(file_handle& file, init_options const& options)
+{
+	if (!file)
+	{
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	if (file.get_multiplexer() == nullptr)
+	{
+		return allio_ERROR(make_error_code(error::handle_is_not_multiplexable));
+	}
+
+	if (options.max_batch_size == 0 || options.max_batch_buffers == 0 || options.max_write_buffers == 0)
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	return { result_value, std::unique_ptr<append_log>(new append_log(file, options)) };
+}
+
+append_log::append_log(file_handle& file, init_options const& options)
+	: m_file(&file)
+	, m_multiplexer(file.get_multiplexer())
+	, m_options(options)
+	, m_tail(options.tail)
+{
+}
+
+append_log::~append_log()
+{
+	allio_ASSERT(!m_busy);
+}
+
+file_offset append_log::get_tail() const
+{
+	std::unique_lock const lock(m_mutex);
+	return m_tail;
+}
+
+void append_log::append(append_operation& operation)
+{
+	std::unique_lock lock(m_mutex);
+
+	if (m_error)
+	{
+		std::error_code const error = m_error;
+		lock.unlock();
+
+		operation.m_complete(operation, allio_ERROR(error));
+		return;
+	}
+
+	m_pending.push(operation);
+
+	// The first append while no batch is in progress starts a new batch.
+	// Later appends are collected into the next batch until the current batch is durable.
+	if (m_busy)
+	{
+		return;
+	}
+
+	m_busy = true;
+	allio_VERIFY(take_batch());
+	lock.unlock();
+
+	run();
+}
+
+void append_log::run()
+{
+	// Operations concluding while being started are handled here rather than by recursing into the next round.
+	do
+	{
+		start_operations();
+	}
+	while (release_operation() && operations_concluded());
+}
+
+bool append_log::take_batch()
+{
+	if (m_pending.empty())
+	{
+		return false;
+	}
+
+	m_batch_buffers.clear();
+	m_batch_buffer_index = 0;
+	m_write_offset = m_tail;
+
+	file_offset offset = m_tail;
+	do
+	{
+		append_operation& operation = m_pending.pop();
+		m_batch.push(operation);
+
+		operation.m_offset = offset;
+		offset += operation.m_size;
+
+		for (untyped_buffer const buffer : operation.m_buffers.buffers())
+		{
+			if (buffer.size() != 0)
+			{
+				m_batch_buffers.push_back(write_buffer(static_cast<std::byte const*>(buffer.data()), buffer.size()));
+			}
+		}
+	}
+	while (!m_pending.empty() &&
+		offset - m_tail + m_pending.head->m_size <= m_options.max_batch_size &&
+		m_batch_buffers.size() + m_pending.head->m_buffers.size() <= m_options.max_batch_buffers);
+
+	m_batch_end = offset;
+
+	return true;
+}
+
+void append_log::start_operations()
+{
+	size_t const remaining = m_batch_buffers.size() - m_batch_buffer_index;
+	size_t const write_buffer_count = std::min(remaining, m_options.max_write_buffers);
+
+	// Once the rest of the batch is written by a single write, it is flushed in the same submission.
+	bool const flush = write_buffer_count == remaining;
+
+	m_write_started = false;
+	m_chained = false;
+	m_write_error = {};
+	m_flush_error = {};
+	m_flush_state = flush_state::none;
+
+	m_operation_count.store(1, std::memory_order_relaxed);
+
+	if (write_buffer_count != 0)
+	{
+		m_chained = flush && m_multiplexer->begin_chain(chain_mode::link).has_value();
+
+		if (auto const r = start_write(write_buffer_count))
+		{
+			m_write_started = true;
+		}
+		else
+		{
+			m_write_error = r.error();
+		}
+	}
+
+	// Without a chain the flush is started after the write has concluded.
+	if (flush && (m_chained || write_buffer_count == 0) && !m_write_error)
+	{
+		if (auto const r = start_flush(); !r)
+		{
+			m_flush_state = flush_state::failed;
+			m_flush_error = r.error();
+		}
+	}
+
+	if (m_chained)
+	{
+		// If the chain cannot be submitted, its operations are concluded with the error.
+		(void)m_multiplexer->end_chain();
+	}
+}
+
+result<void> append_log::start_write(size_t const buffer_count)
+{
+	multiplexer_handle_relation const& relation = m_file->get_multiplexer_relation();
+	async_operation_descriptor const& descriptor = get_descriptor<io::gather_write_at>(*m_file);
+
+	io::parameters_with_result<io::gather_write_at> const arguments(m_write_result, *m_file,
+		m_write_offset, write_buffers(m_batch_buffers.data() + m_batch_buffer_index, buffer_count));
+
+	allio_TRYA(m_write_operation, m_multiplexer->construct(descriptor,
+		m_write_storage.get(relation.operation_storage_requirements), arguments, this));
+
+	m_operation_count.fetch_add(1, std::memory_order_relaxed);
+
+	if (auto const r = m_multiplexer->start(descriptor, *m_write_operation); !r)
+	{
+		m_operation_count.fetch_sub(1, std::memory_order_relaxed);
+		descriptor.destroy(*m_write_operation);
+		return allio_ERROR(r.error());
+	}
+
+	return {};
+}
+
+result<void> append_log::start_flush()
+{
+	multiplexer_handle_relation const& relation = m_file->get_multiplexer_relation();
+	async_operation_descriptor const& descriptor = get_descriptor<io::flush>(*m_file);
+
+	io::parameters_with_result<io::flush> const arguments(m_flush_result, *m_file, m_options.flush_mode);
+
+	allio_TRYA(m_flush_operation, m_multiplexer->construct(descriptor,
+		m_flush_storage.get(relation.operation_storage_requirements), arguments, this));
+
+	m_flush_state = flush_state::started;
+	m_operation_count.fetch_add(1, std::memory_order_relaxed);
+
+	if (auto const r = m_multiplexer->start(descriptor, *m_flush_operation); !r)
+	{
+		m_operation_count.fetch_sub(1, std::memory_order_relaxed);
+		descriptor.destroy(*m_flush_operation);
+		m_flush_state = flush_state::none;
+		return allio_ERROR(r.error());
+	}
+
+	return {};
+}
+
+void append_log::concluded(async_operation& operation)
+{
+	if (&operation == m_write_operation)
+	{
+		if (std::error_code const error = operation.get_result())
+		{
+			m_write_error = error;
+		}
+		get_descriptor<io::gather_write_at>(*m_file).destroy(operation);
+	}
+	else
+	{
+		allio_ASSERT(&operation == m_flush_operation);
+
+		if (std::error_code const error = operation.get_result())
+		{
+			m_flush_state = operation.is_cancelled() ? flush_state::cancelled : flush_state::failed;
+			m_flush_error = error;
+		}
+		else
+		{
+			m_flush_state = flush_state::succeeded;
+		}
+		get_descriptor<io::flush>(*m_file).destroy(operation);
+	}
+
+	// The last operation to conclude continues the batch.
+	if (release_operation() && operations_concluded())
+	{
+		run();
+	}
+}
+
+bool append_log::release_operation()
+{
+	return m_operation_count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+bool append_log::operations_concluded()
+{
+	if (m_write_error)
+	{
+		return complete_batch(m_write_error);
+	}
+
+	if (m_write_started)
+	{
+		size_t written = m_write_result.result;
+
+		if (written == 0)
+		{
+			return complete_batch(make_error_code(std::errc::io_error));
+		}
+
+		m_write_offset += written;
+
+		// Skip the written buffers. A partially written buffer is replaced by its remainder.
+		while (written != 0)
+		{
+			write_buffer& buffer = m_batch_buffers[m_batch_buffer_index];
+
+			if (written < buffer.size())
+			{
+				buffer = write_buffer(buffer.data() + written, buffer.size() - written);
+				break;
+			}
+
+			written -= buffer.size();
+			++m_batch_buffer_index;
+		}
+	}
+
+	// After a short write the flush was either cancelled or did not cover the whole batch.
+	if (m_batch_buffer_index != m_batch_buffers.size())
+	{
+		return true;
+	}
+
+	switch (m_flush_state)
+	{
+	case flush_state::succeeded:
+		return complete_batch({});
+
+	case flush_state::cancelled:
+		// A flush linked after a write is cancelled if the write fails or is short.
+		if (m_chained)
+		{
+			return true;
+		}
+		[[fallthrough]];
+
+	case flush_state::failed:
+		return complete_batch(m_flush_error);
+
+	default:
+		// The write was not linked to a flush, so the flush is started now.
+		return true;
+	}
+}
+
+bool append_log::complete_batch(std::error_code const error)
+{
+	operation_list batch = std::exchange(m_batch, {});
+	operation_list failed;
+	{
+		std::unique_lock const lock(m_mutex);
+
+		if (error)
+		{
+			m_error = error;
+			failed = std::exchange(m_pending, {});
+		}
+		else
+		{
+			m_tail = m_batch_end;
+		}
+	}
+
+	// The operations may be destroyed when completed.
+	while (!batch.empty())
+	{
+		append_operation& operation = batch.pop();
+
+		if (error)
+		{
+			operation.m_complete(operation, allio_ERROR(error));
+		}
+		else
+		{
+			operation.m_complete(operation, operation.m_offset);
+		}
+	}
+
+	while (!failed.empty())
+	{
+		append_operation& operation = failed.pop();
+		operation.m_complete(operation, allio_ERROR(error));
+	}
+
+	// The log remains busy during the completions, so that appends started by them join the next batch
+	// instead of starting it recursively.
+	std::unique_lock const lock(m_mutex);
+
+	if (!m_error && take_batch())
+	{
+		return true;
+	}
+
+	m_busy = false;
+	return false;
+}
@@ -0,0 +1,212 @@
+#include <allio/append_log.hpp>
+
+#include <allio/default_multiplexer.hpp>
+#include <allio/file_handle_async.hpp>
+#include <allio/sync_wait.hpp>
+
+#include <unifex/task.hpp>
+#include <unifex/when_all.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#if allio_detail_LINUX
+#	include <allio/linux/epoll_multiplexer.hpp>
+#endif
+
+#include <filesystem>
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+
+#include <csignal>
+#include <cstring>
+
+#if allio_detail_LINUX
+#	include <sys/resource.h>
+#endif
+
+using namespace allio;
+
+namespace {
+
+// Append started directly on the log, recording its result and the tail of the log at its completion.
+struct test_append : append_log::append_operation
+{
+	append_log* log;
+	std::optional<result<file_offset>> offset;
+	file_offset tail = 0;
+
+	test_append(append_log& log, std::string_view const data)
+		: append_operation(as_write_buffer(data.data(), data.size()), complete)
+		, log(&log)
+	{
+	}
+
+	static void complete(append_operation& operation, result<file_offset> const offset)
+	{
+		auto& self = static_cast<test_append&>(operation);
+		self.offset = offset;
+		self.tail = self.log->get_tail();
+	}
+};
+
+} // namespace
+
+static path get_log_file_path()
+{
+	return path((std::filesystem::temp_directory_path() / "allio-test-log").string());
+}
+
+static file_handle open_log_file(multiplexer& multiplexer)
+{
+	file_handle file;
+	file.set_multiplexer(&multiplexer).value();
+	file.open(get_log_file_path(), { .mode = file_mode::write, .creation = file_creation::truncate_existing }).value();
+	return file;
+}
+
+static void wait(multiplexer& multiplexer, std::initializer_list<test_append*> const appends)
+{
+	for (test_append* const append : appends)
+	{
+		while (!append->offset)
+		{
+			multiplexer.poll().value();
+		}
+	}
+}
+
+static void check_log_content(file_handle& file, std::string_view const content)
+{
+	std::string buffer;
+	buffer.resize(content.size());
+	REQUIRE(file.read_at(0, as_read_buffer(buffer.data(), buffer.size())).value() == content.size());
+	REQUIRE(buffer == content);
+}
+
+// The first append is written by itself. The rest are pending until it is durable, and then form the next batch.
+static void check_batches(multiplexer& multiplexer, append_log::init_options const& options, file_offset const second_tail)
+{
+	file_handle file = open_log_file(multiplexer);
+	std::unique_ptr<append_log> const log = append_log::create(file, options).value();
+
+	test_append a(*log, "aaaa");
+	test_append b(*log, "bbbb");
+	test_append c(*log, "cccc");
+
+	log->append(a);
+	log->append(b);
+	log->append(c);
+	wait(multiplexer, { &a, &b, &c });
+
+	REQUIRE(a.offset->value() == 0);
+	REQUIRE(b.offset->value() == 4);
+	REQUIRE(c.offset->value() == 8);
+
+	REQUIRE(a.tail == 4);
+	REQUIRE(b.tail == second_tail);
+	REQUIRE(c.tail == 12);
+
+	check_log_content(file, "aaaabbbbcccc");
+}
+
+TEST_CASE("append_log::append_async", "[append_log]")
+{
+	path const file_path = path((std::filesystem::temp_directory_path() / "allio-test-log").string());
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path,
+			{ .mode = file_mode::write, .creation = file_creation::truncate_existing });
+
+		std::unique_ptr<append_log> const log = append_log::create(file, { .tail = 0 }).value();
+
+		// The appends started together are written and flushed as one batch.
+		auto const [a, b, c] = co_await unifex::when_all(
+			log->append_async(as_write_buffer("aaaa", 4)),
+			log->append_async(as_write_buffer("bb", 2)),
+			log->append_async(as_write_buffer("cccccc", 6)));
+
+		REQUIRE(std::get<0>(std::get<0>(a)) == 0);
+		REQUIRE(std::get<0>(std::get<0>(b)) == 4);
+		REQUIRE(std::get<0>(std::get<0>(c)) == 6);
+		REQUIRE(log->get_tail() == 12);
+
+		REQUIRE(co_await log->append_async(as_write_buffer("d", 1)) == 12);
+		REQUIRE(log->get_tail() == 13);
+
+		char buffer[13];
+		co_await file.read_at_async(0, as_read_buffer(buffer, 13));
+		REQUIRE(memcmp(buffer, "aaaabbccccccd", 13) == 0);
+	}());
+}
+
+TEST_CASE("append_log batch limits", "[append_log]")
+{
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	SECTION("max_batch_size")
+	{
+		check_batches(*multiplexer, { .max_batch_size = 4 }, 8);
+	}
+
+	SECTION("max_batch_buffers")
+	{
+		check_batches(*multiplexer, { .max_batch_buffers = 1 }, 8);
+	}
+
+	SECTION("max_write_buffers")
+	{
+		// The batch is written by several writes, which resume where the previous one ended, but flushed once.
+		check_batches(*multiplexer, { .max_write_buffers = 1 }, 12);
+	}
+}
+
+#if allio_detail_LINUX
+TEST_CASE("append_log without chaining", "[append_log]")
+{
+	// The epoll multiplexer does not support chains, so each write is followed by a separately started flush.
+	unique_multiplexer const multiplexer = std::make_unique<linux::epoll_multiplexer>(
+		linux::epoll_multiplexer::init({}).value());
+
+	REQUIRE(!multiplexer->begin_chain(chain_mode::link));
+
+	check_batches(*multiplexer, {}, 12);
+}
+
+TEST_CASE("append_log short write and error", "[append_log]")
+{
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	file_handle file = open_log_file(*multiplexer);
+	std::unique_ptr<append_log> const log = append_log::create(file, {}).value();
+
+	// Writes crossing the file size limit are short, and writes starting at the limit fail.
+	rlimit old_limit;
+	REQUIRE(getrlimit(RLIMIT_FSIZE, &old_limit) == 0);
+	rlimit new_limit = old_limit;
+	new_limit.rlim_cur = 10;
+	REQUIRE(setrlimit(RLIMIT_FSIZE, &new_limit) == 0);
+	auto const old_handler = signal(SIGXFSZ, SIG_IGN);
+
+	test_append a(*log, "0123456789abcdef");
+	log->append(a);
+	wait(*multiplexer, { &a });
+
+	REQUIRE(setrlimit(RLIMIT_FSIZE, &old_limit) == 0);
+	signal(SIGXFSZ, old_handler);
+
+	// The remainder of the short write is written at the limit, where it fails.
+	REQUIRE(a.offset->error() == std::errc::file_too_large);
+	REQUIRE(log->get_tail() == 0);
+	check_log_content(file, "0123456789");
+
+	// Once a write has failed, the tail is unknown and all further appends fail with the same error.
+	test_append b(*log, "b");
+	log->append(b);
+	REQUIRE(b.offset);
+	REQUIRE(b.offset->error() == std::errc::file_too_large);
+}
+#endif
@@ -37,7 +37,7 @@ using async_handle_types = detail::make_async_handle_types<
 
 
 #define allio_detail_EXTERN_ASYNC_HANDLE_MULTIPLEXER_RELATIONS(H, M) \
-	extern allio_MULTIPLEXER_HANDLE_RELATION(M, H);
+	extern allio_MULTIPLEXER_HANDLE_RELATION(M, ::allio::H);
 
 #define allio_EXTERN_ASYNC_HANDLE_MULTIPLEXER_RELATIONS(M) \
 	allio_ASYNC_HANDLE_TYPES(allio_detail_EXTERN_ASYNC_HANDLE_MULTIPLEXER_RELATIONS, M)
@@ -0,0 +1,30 @@
+#include <allio/deadline.hpp>
+
+#include <catch2/catch_all.hpp>
+
+using namespace allio;
+
+TEST_CASE("deadline::never is neither relative nor absolute", "[deadline]")
+{
+	REQUIRE(!deadline::never().is_relative());
+	REQUIRE(!deadline::never().is_absolute());
+	REQUIRE(deadline() == deadline::never());
+	REQUIRE(deadline::never().remaining() == std::chrono::nanoseconds::max());
+}
+
+TEST_CASE("deadline conversions saturate", "[deadline]")
+{
+	// Durations not representable in nanoseconds are clamped instead of overflowing.
+	REQUIRE(deadline(std::chrono::hours::max()).is_relative());
+	REQUIRE(deadline(std::chrono::hours::max()).relative() > std::chrono::hours(24 * 365 * 100));
+	REQUIRE(deadline(std::chrono::hours::min()) == deadline::instant());
+
+	// The largest absolute deadline is distinct from never.
+	deadline const absolute = deadline::clock::time_point::max();
+	REQUIRE(absolute.is_absolute());
+	REQUIRE(absolute != deadline::never());
+	REQUIRE(absolute.remaining() > std::chrono::hours(24 * 365 * 100));
+
+	REQUIRE(deadline(std::chrono::milliseconds(1500)).relative() == std::chrono::nanoseconds(1'500'000'000));
+	REQUIRE(deadline(std::chrono::duration<double>(0.5)).relative() == std::chrono::milliseconds(500));
+}
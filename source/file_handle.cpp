@@ -73,4 +73,99 @@ result<size_t> detail::file_handle_base::write_at(file_offset const offset, writ
 	return write_at_sync(offset, buffers);
 }
 
+result<size_t> detail::file_handle_base::transfer_to(file_offset const offset, size_t const size, platform_handle const& target)
+{
+	if (!*this || !target)
+	{
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	if (multiplexer* const multiplexer = get_multiplexer())
+	{
+		if (!is_synchronous<io::transfer>(*this))
+		{
+			return block<io::transfer>(*this, offset, size, &target);
+		}
+	}
+
+	return transfer_to_sync(offset, size, target);
+}
+
+result<file_offset> detail::file_handle_base::flush(file_flush_mode const mode, flush_parameters const& args)
+{
+	if (!*this)
+	{
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	if (multiplexer* const multiplexer = get_multiplexer())
+	{
+		if (!is_synchronous<io::flush>(*this))
+		{
+			return block<io::flush>(*this, mode, args);
+		}
+	}
+
+	return flush_sync(mode, args);
+}
+
+result<file_offset> detail::file_handle_base::flush_range(file_offset const offset, uint64_t const size)
+{
+	if (!*this)
+	{
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	if (size == 0 || offset + size < offset)
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	if (multiplexer* const multiplexer = get_multiplexer())
+	{
+		if (!is_synchronous<io::flush_range>(*this))
+		{
+			return block<io::flush_range>(*this, offset, size);
+		}
+	}
+
+	return flush_range_sync(offset, size);
+}
+
+result<void> detail::file_handle_base::allocate(file_allocation_mode const mode, file_offset const offset, uint64_t const size)
+{
+	if (!*this)
+	{
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	if (multiplexer* const multiplexer = get_multiplexer())
+	{
+		if (!is_synchronous<io::allocate>(*this))
+		{
+			return block<io::allocate>(*this, mode, offset, size);
+		}
+	}
+
+	return allocate_sync(mode, offset, size);
+}
+
+result<void> detail::file_handle_base::set_size(file_offset const size)
+{
+	if (!*this)
+	{
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	if (multiplexer* const multiplexer = get_multiplexer())
+	{
+		if (!is_synchronous<io::set_size>(*this))
+		{
+			return block<io::set_size>(*this, size);
+		}
+	}
+
+	return set_size_sync(size);
+}
+
 allio_TYPE_ID(file_handle);
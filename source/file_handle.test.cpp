@@ -1,17 +1,30 @@
 #include <allio/file_handle_async.hpp>
 
 #include <allio/default_multiplexer.hpp>
+#include <allio/socket_handle_async.hpp>
 #include <allio/sync_wait.hpp>
 
 #include <unifex/task.hpp>
+#include <unifex/when_all.hpp>
 
 #include <catch2/catch_all.hpp>
 
+#if allio_detail_LINUX
+#	include <allio/linux/io_uring_multiplexer.hpp>
+#endif
+
+#include <chrono>
 #include <filesystem>
+#include <string>
+#include <system_error>
 
 #include <cstdio>
 #include <cstring>
 
+#if allio_detail_LINUX
+#	include <sys/stat.h>
+#endif
+
 using namespace allio;
 
 namespace {
@@ -56,6 +69,25 @@ static void write_file_content(path const& path, std::string_view const content)
 	REQUIRE(fwrite(content.data(), content.size(), 1, file.get()) == 1);
 }
 
+#if allio_detail_LINUX
+static uint64_t get_allocated_size(path const& path)
+{
+	struct stat stat;
+	REQUIRE(::stat(path.string().c_str(), &stat) == 0);
+	return static_cast<uint64_t>(stat.st_blocks) * 512;
+}
+
+static std::unique_ptr<linux::io_uring_multiplexer> create_io_uring_multiplexer(linux::io_uring_multiplexer::init_options const& options = {})
+{
+	auto init_result = linux::io_uring_multiplexer::init(options);
+	if (!init_result)
+	{
+		SKIP("io_uring is not available with the requested options");
+	}
+	return std::make_unique<linux::io_uring_multiplexer>(std::move(*init_result));
+}
+#endif
+
 static void maybe_set_multiplexer(unique_multiplexer const& multiplexer, auto& handle)
 {
 	if (GENERATE(0, 1))
@@ -133,3 +165,414 @@ TEST_CASE("file_handle::write_at_async", "[file_handle]")
 	}());
 	check_file_content(file_path, "allio");
 }
+
+TEST_CASE("file_handle::flush_async", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	write_file_content(file_path, "trash");
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path,
+			{ .mode = file_mode::write, .creation = file_creation::open_existing });
+
+		co_await file.write_at_async(5, as_write_buffer("allio", 5));
+
+		// The sampled size covers the write completed before the flush.
+		file_offset const durable_size = co_await file.flush_async(file_flush_mode::data, { .sample_size = true });
+		REQUIRE(durable_size == 10);
+
+		// Without sampling the size is not reported.
+		REQUIRE(co_await file.flush_async(file_flush_mode::all) == 0);
+	}());
+	check_file_content(file_path, "trashallio");
+}
+
+#if allio_detail_LINUX
+TEST_CASE("file_handle::flush direct descriptor", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	unique_multiplexer const multiplexer = create_io_uring_multiplexer();
+
+	write_file_content(file_path, "trash");
+
+	file_handle file;
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file = co_await open_file_async(*multiplexer, file_path,
+			{ .handle_flags = flags::multiplexer_bound, .mode = file_mode::write, .creation = file_creation::open_existing });
+
+		co_await file.write_at_async(5, as_write_buffer("allio", 5));
+	}());
+
+	// The size of a direct descriptor cannot be sampled.
+	REQUIRE(file.flush(file_flush_mode::data, { .sample_size = true }).error() == std::errc::not_supported);
+	REQUIRE(file.flush(file_flush_mode::data).value() == 0);
+
+	file.close().value();
+	check_file_content(file_path, "trashallio");
+}
+#endif
+
+TEST_CASE("file_handle::close_async", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	// On io_uring a multiplexer bound file is a direct descriptor, whose slot is released when the close completes.
+	flags const handle_flags = GENERATE(flags::none, flags::multiplexer_bound);
+
+	write_file_content(file_path, "trash");
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		// Reopening after each close reuses the released slot.
+		for (int i = 0; i < 3; ++i)
+		{
+			file_handle file = co_await open_file_async(*multiplexer, file_path,
+				{ .handle_flags = handle_flags, .mode = file_mode::write, .creation = file_creation::truncate_existing });
+
+			co_await file.write_at_async(0, as_write_buffer("allio", 5));
+
+			co_await file.close_async();
+			REQUIRE(!file);
+		}
+	}());
+	check_file_content(file_path, "allio");
+}
+
+#if allio_detail_LINUX
+TEST_CASE("file_handle registered buffers", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	auto const multiplexer = create_io_uring_multiplexer({ .buffer_table_size = 1 });
+
+	std::byte memory[4096];
+	registered_buffer const buffer = multiplexer->register_buffer(memory).value();
+	memcpy(memory, "allio", 5);
+
+	write_file_content(file_path, "trash-trash");
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path,
+			{ .mode = file_mode::write, .creation = file_creation::open_existing });
+
+		// Subspans of a registered buffer refer to the same registration.
+		REQUIRE(co_await file.write_at_async(0, buffer.subspan(0, 5)) == 5);
+		REQUIRE(co_await file.read_at_async(6, buffer.subspan(8, 5)) == 5);
+	}());
+
+	REQUIRE(memcmp(memory + 8, "trash", 5) == 0);
+	multiplexer->deregister_buffer(buffer).value();
+
+	check_file_content(file_path, "allio-trash");
+}
+#endif
+
+#if allio_detail_LINUX
+TEST_CASE("file_handle fixed file table", "[file_handle]")
+{
+	path const file_path_1 = get_temp_file_path("allio-test-file");
+	path const file_path_2 = get_temp_file_path("allio-test-file-2");
+
+	auto const multiplexer = create_io_uring_multiplexer({ .file_table_size = 1 });
+
+	write_file_content(file_path_1, "trash");
+	write_file_content(file_path_2, "trash");
+
+	file_handle file_1;
+	file_handle file_2;
+	file_1.set_multiplexer(multiplexer.get()).value();
+	file_2.set_multiplexer(multiplexer.get()).value();
+	file_1.open(file_path_1, { .mode = file_mode::write, .creation = file_creation::open_existing }).value();
+	file_2.open(file_path_2, { .mode = file_mode::write, .creation = file_creation::open_existing }).value();
+
+	// The first file takes the only slot. The second falls back to its file descriptor.
+	REQUIRE(file_1.get_multiplexer_data() != nullptr);
+	REQUIRE(file_2.get_multiplexer_data() == nullptr);
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		REQUIRE(co_await file_1.write_at_async(0, as_write_buffer("allio", 5)) == 5);
+		REQUIRE(co_await file_2.write_at_async(0, as_write_buffer("allio", 5)) == 5);
+	}());
+
+	// Closing the first file frees the slot for the next registration.
+	file_1.close().value();
+	file_1.open(file_path_1).value();
+	REQUIRE(file_1.get_multiplexer_data() != nullptr);
+
+	check_file_content(file_path_1, "allio");
+	check_file_content(file_path_2, "allio");
+}
+#endif
+
+// Probe whether the file system of the temporary directory supports unbuffered files.
+static void require_unbuffered_support(path const& path)
+{
+	file_handle file;
+	if (auto const r = file.open(path, { .mode = file_mode::write, .creation = file_creation::truncate_existing, .caching = file_caching::unbuffered }); !r)
+	{
+		REQUIRE(r.error() == std::errc::invalid_argument);
+		SKIP("The file system does not support unbuffered files");
+	}
+}
+
+TEST_CASE("file_handle unbuffered", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	require_unbuffered_support(file_path);
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	file_caching const caching = GENERATE(file_caching::unbuffered, file_caching::unbuffered_write_through);
+
+	// Unbuffered transfers are aligned to the logical block size of the device.
+	alignas(4096) std::byte write_data[4096];
+	alignas(4096) std::byte read_data[4096];
+	memset(write_data, 'a', sizeof(write_data));
+	memset(read_data, 0, sizeof(read_data));
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path,
+			{ .mode = file_mode::write, .creation = file_creation::truncate_existing, .caching = caching });
+
+		REQUIRE(co_await file.write_at_async(0, as_write_buffer(write_data, sizeof(write_data))) == sizeof(write_data));
+		REQUIRE(co_await file.read_at_async(0, as_read_buffer(read_data, sizeof(read_data))) == sizeof(read_data));
+	}()).value();
+
+	REQUIRE(memcmp(read_data, write_data, sizeof(read_data)) == 0);
+}
+
+#if allio_detail_LINUX
+TEST_CASE("file_handle completion polling", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	require_unbuffered_support(file_path);
+
+	auto const multiplexer = create_io_uring_multiplexer({ .enable_completion_polling = true });
+	REQUIRE(multiplexer->has_completion_polling());
+
+	// Only reads and writes complete on a polling multiplexer, so the file is opened synchronously.
+	file_handle file;
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file = co_await open_file_async(*multiplexer, file_path,
+			{ .mode = file_mode::write, .creation = file_creation::truncate_existing, .caching = file_caching::unbuffered });
+	}()).value();
+	REQUIRE(file);
+
+	alignas(4096) std::byte write_data[4096];
+	alignas(4096) std::byte read_data[4096];
+	memset(write_data, 'a', sizeof(write_data));
+	memset(read_data, 0, sizeof(read_data));
+
+	auto const get_error = [&](auto&& sender) -> std::error_code
+	{
+		try
+		{
+			auto const r = sync_wait(*multiplexer, static_cast<decltype(sender)&&>(sender));
+			return r ? std::error_code() : r.error();
+		}
+		catch (std::system_error const& e)
+		{
+			return e.code();
+		}
+	};
+
+	// Linked timeouts cannot be polled for.
+	REQUIRE(get_error(file.write_at_async(0, as_write_buffer(write_data, sizeof(write_data))).with_deadline(std::chrono::seconds(1))) == std::errc::not_supported);
+
+	if (std::error_code const error = get_error(file.write_at_async(0, as_write_buffer(write_data, sizeof(write_data)))))
+	{
+		REQUIRE(error == std::errc::operation_not_supported);
+		SKIP("The file system does not support completion polling");
+	}
+
+	REQUIRE(!get_error(file.read_at_async(0, as_read_buffer(read_data, sizeof(read_data)))));
+	REQUIRE(memcmp(read_data, write_data, sizeof(read_data)) == 0);
+}
+#endif
+
+TEST_CASE("file_handle::set_size", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	unique_multiplexer const multiplexer = allio::create_default_multiplexer().value();
+
+	write_file_content(file_path, "allio-trash");
+	{
+		allio::file_handle file;
+		maybe_set_multiplexer(multiplexer, file);
+		file.open(file_path, { .mode = file_mode::write, .creation = file_creation::open_existing, .allocation_size = 4096 }).value();
+
+		// Allocating without changing the size leaves the content intact.
+		file.allocate(file_allocation_mode::keep_size, 0, 8192).value();
+		file.set_size(5).value();
+	}
+	check_file_content(file_path, "allio");
+	REQUIRE(std::filesystem::file_size(file_path.string()) == 5);
+}
+
+TEST_CASE("file_handle::allocate_async", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	write_file_content(file_path, "allio");
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path,
+			{ .mode = file_mode::write, .creation = file_creation::open_existing });
+
+		// Allocating without changing the size leaves the content intact.
+		co_await file.allocate_async(file_allocation_mode::keep_size, 0, 65536);
+
+		// Allocating beyond the end of the file extends it.
+		co_await file.allocate_async(file_allocation_mode::allocate, 0, 8192);
+	}());
+	check_file_content(file_path, "allio");
+	REQUIRE(std::filesystem::file_size(file_path.string()) == 8192);
+#if allio_detail_LINUX
+	REQUIRE(get_allocated_size(file_path) >= 65536);
+#endif
+}
+
+TEST_CASE("file_handle::set_size_async", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	write_file_content(file_path, "allio-trash");
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path,
+			{ .mode = file_mode::write, .creation = file_creation::open_existing });
+
+		co_await file.set_size_async(5);
+	}());
+	check_file_content(file_path, "allio");
+	REQUIRE(std::filesystem::file_size(file_path.string()) == 5);
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path,
+			{ .mode = file_mode::write, .creation = file_creation::open_existing });
+
+		// The extension reads as zeros.
+		co_await file.set_size_async(4096);
+	}());
+	check_file_content(file_path, std::string_view("allio\0\0\0", 8));
+	REQUIRE(std::filesystem::file_size(file_path.string()) == 4096);
+}
+
+TEST_CASE("file_handle::open_file_async allocation_size", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	// On io_uring a multiplexer bound file is opened into a fixed file slot, and preallocated by a linked fallocate.
+	flags const handle_flags = GENERATE(flags::none, flags::multiplexer_bound);
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path,
+			{ .handle_flags = handle_flags, .mode = file_mode::write, .creation = file_creation::truncate_existing, .allocation_size = 65536 });
+
+		co_await file.write_at_async(0, as_write_buffer("allio", 5));
+		co_await file.close_async();
+	}());
+	check_file_content(file_path, "allio");
+
+	// Preallocation does not change the size of the file.
+	REQUIRE(std::filesystem::file_size(file_path.string()) == 5);
+#if allio_detail_LINUX
+	REQUIRE(get_allocated_size(file_path) >= 65536);
+#endif
+}
+
+#if allio_detail_LINUX
+TEST_CASE("file_handle::transfer_to_async", "[file_handle]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	auto const multiplexer = create_io_uring_multiplexer({ .file_table_size = 1 });
+
+	// A multiplexer bound file is a direct descriptor, which is spliced from its fixed file slot.
+	int const bound = GENERATE(0, 1);
+	flags const handle_flags = bound ? flags::multiplexer_bound : flags::none;
+
+	// Each generated case listens on its own port, as the previous one may linger in TIME_WAIT.
+	network_address const address = ipv4_address::localhost(static_cast<uint16_t>(51244 + bound));
+
+	// The splice pipe holds at most 1 MiB, so transferring the whole file takes more than one operation.
+	std::string content(3 * 512 * 1024, '\0');
+	for (size_t i = 0; i < content.size(); ++i)
+	{
+		content[i] = static_cast<char>(i * 7 + i / 4096);
+	}
+	write_file_content(file_path, content);
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		file_handle file = co_await open_file_async(*multiplexer, file_path, { .handle_flags = handle_flags });
+
+		listen_socket_handle listen_socket = co_await listen_async(*multiplexer, address);
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = (co_await listen_socket.accept_async()).socket;
+				socket.set_multiplexer(multiplexer.get());
+
+				size_t transferred = 0;
+				size_t transfer_count = 0;
+
+				// Like a write, each transfer may be partial.
+				while (transferred < content.size())
+				{
+					size_t const size = co_await file.transfer_to_async(transferred, content.size() - transferred, socket);
+					REQUIRE(size != 0);
+					REQUIRE(size <= content.size() - transferred);
+
+					transferred += size;
+					++transfer_count;
+				}
+
+				REQUIRE(transfer_count > 1);
+
+				// Transfers starting at or past the end of the file transfer nothing.
+				REQUIRE(co_await file.transfer_to_async(content.size(), 4096, socket) == 0);
+				REQUIRE(co_await file.transfer_to_async(content.size() + 4096, 4096, socket) == 0);
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = co_await connect_async(*multiplexer, address);
+
+				std::string received(content.size(), '\0');
+				size_t received_size = 0;
+
+				while (received_size < received.size())
+				{
+					size_t const size = co_await socket.read_async(as_read_buffer(received.data() + received_size, received.size() - received_size));
+					REQUIRE(size != 0);
+					received_size += size;
+				}
+
+				REQUIRE(received == content);
+			}()
+		);
+	}());
+}
+#endif
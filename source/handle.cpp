@@ -11,6 +11,12 @@ result<void> handle::set_multiplexer(multiplexer* const multiplexer, multiplexer
 		return allio_ERROR(error::handle_is_not_multiplexable);
 	}
 
+	// Re-registration would close a handle bound to its multiplexer.
+	if (multiplexer != nullptr && multiplexer == m_multiplexer.value)
+	{
+		return {};
+	}
+
 	if (m_multiplexer.value != nullptr)
 	{
 		if (is_valid)
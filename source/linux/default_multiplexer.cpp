@@ -1,7 +1,11 @@
 #include <allio/default_multiplexer.hpp>
 
+#include <allio/linux/epoll_multiplexer.hpp>
 #include <allio/linux/io_uring_multiplexer.hpp>
 
+#include <algorithm>
+#include <thread>
+
 #include <sys/syscall.h>
 #include <unistd.h>
 
@@ -21,17 +25,38 @@ static bool is_io_uring_supported()
 	return is_supported;
 }
 
+// io_uring may be present but denied, e.g. by seccomp filters or the io_uring_disabled sysctl.
+static bool is_io_uring_denied(std::error_code const error)
+{
+	return error == std::errc::function_not_supported || error == std::errc::operation_not_permitted;
+}
+
 result<unique_multiplexer> allio::create_default_multiplexer(default_multiplexer_options const& options)
 {
 	if (is_io_uring_supported())
 	{
-		allio_TRY(result, io_uring_multiplexer::init(
+		auto io_uring_result = io_uring_multiplexer::init(
 		{
 			.enable_concurrent_submission = options.enable_concurrent_submission,
 			.enable_concurrent_completion = options.enable_concurrent_completion,
-		}));
-		return std::make_unique<io_uring_multiplexer>(std::move(result));
+		});
+
+		if (io_uring_result)
+		{
+			return std::make_unique<io_uring_multiplexer>(std::move(*io_uring_result));
+		}
+
+		if (!is_io_uring_denied(io_uring_result.error()))
+		{
+			return allio_ERROR(io_uring_result.error());
+		}
 	}
 
-	return allio_ERROR(make_error_code(std::errc::not_supported));
+	allio_TRY(result, epoll_multiplexer::init(
+	{
+		.enable_concurrent_submission = options.enable_concurrent_submission,
+		.enable_concurrent_completion = options.enable_concurrent_completion,
+		.worker_thread_count = std::clamp(std::thread::hardware_concurrency(), 1u, 4u),
+	}));
+	return std::make_unique<epoll_multiplexer>(std::move(result));
 }
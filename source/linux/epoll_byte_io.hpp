@@ -0,0 +1,141 @@
+#pragma once
+
+#include <allio/byte_io.hpp>
+#include <allio/platform_handle.hpp>
+#include <allio/static_multiplexer_handle_relation_provider.hpp>
+#include <allio/linux/epoll_multiplexer.hpp>
+#include <allio/linux/platform.hpp>
+
+#include "error.hpp"
+
+#include <sys/uio.h>
+
+#include <allio/linux/detail/undef.i>
+
+namespace allio {
+
+struct epoll_scatter_gather_async_operation_storage
+	: linux::epoll_multiplexer::async_operation_storage
+	, io::scatter_gather_parameters
+{
+	handle const* handle;
+	size_t* transferred;
+
+	template<typename Parameters>
+	epoll_scatter_gather_async_operation_storage(Parameters const& arguments, async_operation_listener* const listener)
+		: async_operation_storage(arguments, listener)
+		, io::scatter_gather_parameters(arguments)
+		, handle(arguments.handle)
+		, transferred(arguments.result)
+	{
+	}
+
+	int get_fd() const
+	{
+		return linux::unwrap_handle(static_cast<platform_handle const*>(handle)->get_platform_handle());
+	}
+
+	// untyped_buffer is layout compatible with iovec.
+	iovec const* get_iovecs() const
+	{
+		return reinterpret_cast<iovec const*>(buffers.data());
+	}
+
+	int get_iovec_count() const
+	{
+		return static_cast<int>(buffers.size());
+	}
+
+	result<void> set_result(ssize_t const result)
+	{
+		if (result == -1)
+		{
+			return allio_ERROR(linux::get_last_error_code());
+		}
+
+		*transferred = static_cast<size_t>(result);
+		return {};
+	}
+};
+
+// Random access operations on files never wait for readiness, so they are performed by the worker threads.
+
+template<std::derived_from<platform_handle> Handle>
+struct multiplexer_handle_operation_implementation<linux::epoll_multiplexer, Handle, io::scatter_read_at>
+{
+	using async_operation_storage = epoll_scatter_gather_async_operation_storage;
+
+	static result<void> start(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.push_work(s, +[](async_operation_storage& s) -> result<void>
+		{
+			return s.set_result(preadv(s.get_fd(), s.get_iovecs(), s.get_iovec_count(), s.offset));
+		});
+	}
+
+	static result<void> cancel(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<std::derived_from<platform_handle> Handle>
+struct multiplexer_handle_operation_implementation<linux::epoll_multiplexer, Handle, io::gather_write_at>
+{
+	using async_operation_storage = epoll_scatter_gather_async_operation_storage;
+
+	static result<void> start(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.push_work(s, +[](async_operation_storage& s) -> result<void>
+		{
+			return s.set_result(pwritev(s.get_fd(), s.get_iovecs(), s.get_iovec_count(), s.offset));
+		});
+	}
+
+	static result<void> cancel(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<std::derived_from<platform_handle> Handle>
+struct multiplexer_handle_operation_implementation<linux::epoll_multiplexer, Handle, io::stream_scatter_read>
+{
+	using async_operation_storage = epoll_scatter_gather_async_operation_storage;
+
+	static result<void> start(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.push(s, *s.handle, linux::epoll_multiplexer::readiness::read, +[](async_operation_storage& s) -> result<void>
+		{
+			return s.set_result(readv(s.get_fd(), s.get_iovecs(), s.get_iovec_count()));
+		});
+	}
+
+	static result<void> cancel(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<std::derived_from<platform_handle> Handle>
+struct multiplexer_handle_operation_implementation<linux::epoll_multiplexer, Handle, io::stream_gather_write>
+{
+	using async_operation_storage = epoll_scatter_gather_async_operation_storage;
+
+	static result<void> start(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.push(s, *s.handle, linux::epoll_multiplexer::readiness::write, +[](async_operation_storage& s) -> result<void>
+		{
+			return s.set_result(writev(s.get_fd(), s.get_iovecs(), s.get_iovec_count()));
+		});
+	}
+
+	static result<void> cancel(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+} // namespace allio
+
+#include <allio/linux/detail/undef.i>
@@ -0,0 +1,137 @@
+#include <allio/file_handle.hpp>
+#include <allio/linux/epoll_multiplexer.hpp>
+
+#include <allio/static_multiplexer_handle_relation_provider.hpp>
+
+#include "epoll_byte_io.hpp"
+#include "epoll_platform_handle.hpp"
+#include "file_handle.hpp"
+#include "filesystem_handle.hpp"
+
+#include <allio/linux/detail/undef.i>
+
+using namespace allio;
+using namespace allio::linux;
+
+// Regular files are always ready and cannot be added to an epoll set.
+template<>
+struct allio::multiplexer_handle_implementation<epoll_multiplexer, allio::file_handle>
+{
+	static result<void*> register_handle(epoll_multiplexer& m, allio::file_handle const& h)
+	{
+		return nullptr;
+	}
+
+	static result<void> deregister_handle(epoll_multiplexer& m, allio::file_handle const& h)
+	{
+		return {};
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, allio::file_handle, io::open_file>
+{
+	using async_operation_storage = epoll_multiplexer::basic_async_operation_storage<io::open_file>;
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		allio_ASSERT((s.args.handle_flags & flags::multiplexable) != flags::none);
+
+		return m.push_work(s, +[](async_operation_storage& s) -> result<void>
+		{
+			allio_ASSERT(!*s.handle);
+			allio_TRY(file, create_file(s.base, s.path, s.args));
+			return consume_platform_handle(static_cast<allio::file_handle&>(*s.handle), { s.args.handle_flags }, std::move(file));
+		});
+	}
+
+	static result<void> cancel(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, allio::file_handle, io::flush>
+{
+	using async_operation_storage = epoll_multiplexer::basic_async_operation_storage<io::flush>;
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.push_work(s, +[](async_operation_storage& s) -> result<void>
+		{
+			allio_TRYA(*s.result, flush_file(unwrap_handle(static_cast<platform_handle const&>(*s.handle).get_platform_handle()), s.mode, s.args));
+			return {};
+		});
+	}
+
+	static result<void> cancel(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, allio::file_handle, io::flush_range>
+{
+	using async_operation_storage = epoll_multiplexer::basic_async_operation_storage<io::flush_range>;
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		if (s.size == 0 || s.offset + s.size < s.offset)
+		{
+			return allio_ERROR(make_error_code(std::errc::invalid_argument));
+		}
+
+		return m.push_work(s, +[](async_operation_storage& s) -> result<void>
+		{
+			allio_TRYA(*s.result, flush_file_range(unwrap_handle(static_cast<platform_handle const&>(*s.handle).get_platform_handle()), s.offset, s.size));
+			return {};
+		});
+	}
+
+	static result<void> cancel(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, allio::file_handle, io::allocate>
+{
+	using async_operation_storage = epoll_multiplexer::basic_async_operation_storage<io::allocate>;
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.push_work(s, +[](async_operation_storage& s) -> result<void>
+		{
+			return allocate_file(unwrap_handle(static_cast<platform_handle const&>(*s.handle).get_platform_handle()), s.mode, s.offset, s.size);
+		});
+	}
+
+	static result<void> cancel(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, allio::file_handle, io::set_size>
+{
+	using async_operation_storage = epoll_multiplexer::basic_async_operation_storage<io::set_size>;
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.push_work(s, +[](async_operation_storage& s) -> result<void>
+		{
+			return set_file_size(unwrap_handle(static_cast<platform_handle const&>(*s.handle).get_platform_handle()), s.size);
+		});
+	}
+
+	static result<void> cancel(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+allio_MULTIPLEXER_HANDLE_RELATION(epoll_multiplexer, allio::file_handle);
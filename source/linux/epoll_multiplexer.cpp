@@ -0,0 +1,680 @@
+#include <allio/linux/epoll_multiplexer.hpp>
+
+#include <allio/detail/assert.hpp>
+#include <allio/static_multiplexer_handle_relation_provider.hpp>
+
+#include "error.hpp"
+#include "../async_handle_types.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <allio/linux/detail/undef.i>
+
+using namespace allio;
+using namespace allio::linux;
+
+allio_EXTERN_ASYNC_HANDLE_MULTIPLEXER_RELATIONS(epoll_multiplexer);
+
+static constexpr uint32_t handle_events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+static constexpr uint32_t read_events = EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR;
+static constexpr uint32_t write_events = EPOLLOUT | EPOLLHUP | EPOLLERR;
+
+static constexpr size_t max_poll_events = 64;
+
+static result<void> set_blocking(int const fd, bool const blocking)
+{
+	int const flags = fcntl(fd, F_GETFL);
+
+	if (flags == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	int const new_flags = blocking
+		? flags & ~O_NONBLOCK
+		: flags | O_NONBLOCK;
+
+	if (new_flags != flags && fcntl(fd, F_SETFL, new_flags) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return {};
+}
+
+// Convert a wait duration to an epoll timeout in milliseconds, rounding up.
+static int get_epoll_timeout(std::chrono::nanoseconds const duration)
+{
+	auto const milliseconds = std::chrono::ceil<std::chrono::milliseconds>(duration).count();
+	return static_cast<int>(std::clamp<decltype(milliseconds)>(milliseconds, 0, std::numeric_limits<int>::max()));
+}
+
+
+void epoll_multiplexer::operation_list::push(async_operation_storage& storage)
+{
+	allio_ASSERT(storage.m_next == nullptr);
+
+	if (m_head == nullptr)
+	{
+		m_head = &storage;
+	}
+	else
+	{
+		m_tail->m_next = &storage;
+	}
+	m_tail = &storage;
+}
+
+void epoll_multiplexer::operation_list::push(operation_list& list)
+{
+	if (list.m_head != nullptr)
+	{
+		if (m_head == nullptr)
+		{
+			m_head = std::exchange(list.m_head, nullptr);
+		}
+		else
+		{
+			m_tail->m_next = std::exchange(list.m_head, nullptr);
+		}
+		m_tail = std::exchange(list.m_tail, nullptr);
+	}
+}
+
+epoll_multiplexer::async_operation_storage& epoll_multiplexer::operation_list::pop()
+{
+	allio_ASSERT(m_head != nullptr);
+	async_operation_storage& storage = *m_head;
+
+	if ((m_head = std::exchange(storage.m_next, nullptr)) == nullptr)
+	{
+		m_tail = nullptr;
+	}
+
+	return storage;
+}
+
+bool epoll_multiplexer::operation_list::remove(async_operation_storage& storage)
+{
+	async_operation_storage* prev = nullptr;
+
+	for (async_operation_storage* next = m_head; next != nullptr; prev = std::exchange(next, next->m_next))
+	{
+		if (next == &storage)
+		{
+			(prev != nullptr ? prev->m_next : m_head) = storage.m_next;
+
+			if (m_tail == &storage)
+			{
+				m_tail = prev;
+			}
+
+			storage.m_next = nullptr;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+result<epoll_multiplexer::init_result> epoll_multiplexer::init(init_options const& options)
+{
+	allio_TRY(epoll, []() -> result<detail::unique_fd>
+	{
+		int const epoll = epoll_create1(EPOLL_CLOEXEC);
+
+		if (epoll == -1)
+		{
+			return allio_ERROR(get_last_error_code());
+		}
+
+		return { result_value, epoll };
+	}());
+
+	// Worker threads signal completions through the event, which is identified by a null pointer.
+	allio_TRY(event, []() -> result<detail::unique_fd>
+	{
+		int const event = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+		if (event == -1)
+		{
+			return allio_ERROR(get_last_error_code());
+		}
+
+		return { result_value, event };
+	}());
+
+	epoll_event event_event = {};
+	event_event.events = EPOLLIN;
+	event_event.data.ptr = nullptr;
+
+	if (epoll_ctl(epoll.get(), EPOLL_CTL_ADD, event.get(), &event_event) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+
+	result<init_result> result = { result_value };
+	result->epoll = std::move(epoll);
+	result->event = std::move(event);
+	result->worker_thread_count = options.worker_thread_count;
+	result->enable_concurrency = options.enable_concurrent_submission || options.enable_concurrent_completion;
+	return result;
+}
+
+epoll_multiplexer::epoll_multiplexer(init_result&& resources)
+{
+	allio_ASSERT(resources.epoll);
+	allio_ASSERT(resources.event);
+
+	m_epoll = resources.epoll.release();
+	m_event = resources.event.release();
+
+	if (resources.enable_concurrency)
+	{
+		m_mutex.emplace();
+	}
+
+	m_workers.reserve(resources.worker_thread_count);
+	for (uint32_t i = 0; i < resources.worker_thread_count; ++i)
+	{
+		m_workers.emplace_back([this]()
+		{
+			work();
+		});
+	}
+}
+
+epoll_multiplexer::~epoll_multiplexer()
+{
+	{
+		std::unique_lock<std::mutex> const work_lock(m_work_mutex);
+		m_work_stop = true;
+	}
+	m_work_condition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	for (handle_state* const state : m_retired_handle_states)
+	{
+		delete state;
+	}
+
+	detail::fd_deleter::release(m_event);
+	detail::fd_deleter::release(m_epoll);
+}
+
+
+type_id<multiplexer> epoll_multiplexer::get_type_id() const
+{
+	return type_of(*this);
+}
+
+result<multiplexer_handle_relation const*> epoll_multiplexer::find_handle_relation(type_id<handle> const handle_type) const
+{
+	return static_multiplexer_handle_relation_provider<epoll_multiplexer, async_handle_types>::find_handle_relation(handle_type);
+}
+
+
+result<void> epoll_multiplexer::poll(deadline const deadline)
+{
+	operation_list completion_list;
+	result<void> poll_result;
+	{
+		auto lock = this->lock(m_mutex);
+
+		completion_list.push(m_completion_list);
+
+		int timeout = -1;
+		if (!completion_list.empty() || deadline == deadline::instant())
+		{
+			timeout = 0;
+		}
+		else
+		{
+			auto const now = deadline::clock::now();
+
+			if (deadline != deadline::never())
+			{
+				timeout = get_epoll_timeout(deadline.remaining(now));
+			}
+
+			if (!m_timers.empty())
+			{
+				int const timer_timeout = get_epoll_timeout(m_timers.begin()->first - now);
+				timeout = timeout == -1 ? timer_timeout : std::min(timeout, timer_timeout);
+			}
+		}
+
+		++m_poll_count;
+
+		epoll_event events[max_poll_events];
+
+		if (lock.owns_lock())
+		{
+			lock.unlock();
+		}
+
+		int const event_count = epoll_wait(m_epoll, events, max_poll_events, timeout);
+
+		if (lock.mutex() != nullptr)
+		{
+			lock.lock();
+		}
+
+		if (event_count == -1 && errno != EINTR)
+		{
+			poll_result = allio_ERROR(get_last_error_code());
+		}
+
+		for (int i = 0; i < event_count; ++i)
+		{
+			epoll_event const& event = events[i];
+
+			if (event.data.ptr == nullptr)
+			{
+				operation_list work_completion_list;
+				{
+					std::unique_lock<std::mutex> const work_lock(m_work_mutex);
+
+					eventfd_t value;
+					(void)eventfd_read(m_event, &value);
+
+					work_completion_list.push(m_work_completion_list);
+				}
+
+				while (!work_completion_list.empty())
+				{
+					async_operation_storage& storage = work_completion_list.pop();
+					complete(storage, storage.m_perform_result, completion_list);
+				}
+
+				continue;
+			}
+
+			auto const state = static_cast<handle_state*>(event.data.ptr);
+
+			if (state->fd == -1)
+			{
+				continue;
+			}
+
+			if ((event.events & read_events) != 0)
+			{
+				perform_waiters(state->waiters[static_cast<size_t>(readiness::read)], completion_list);
+			}
+
+			if ((event.events & write_events) != 0)
+			{
+				perform_waiters(state->waiters[static_cast<size_t>(readiness::write)], completion_list);
+			}
+		}
+
+		if (--m_poll_count == 0)
+		{
+			for (handle_state* const state : m_retired_handle_states)
+			{
+				delete state;
+			}
+			m_retired_handle_states.clear();
+		}
+
+		if (!m_timers.empty())
+		{
+			expire_timers(deadline::clock::now(), completion_list);
+		}
+
+		completion_list.push(m_completion_list);
+	}
+
+	flush(completion_list);
+	return poll_result;
+}
+
+
+result<void*> epoll_multiplexer::register_native_handle(native_platform_handle const handle)
+{
+	if (is_direct_handle(handle))
+	{
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+
+	int const fd = unwrap_handle(handle);
+
+	int const flags = fcntl(fd, F_GETFL);
+	if (flags == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	auto state = std::make_unique<handle_state>();
+	state->fd = fd;
+	state->restore_blocking = (flags & O_NONBLOCK) == 0;
+
+	allio_TRYV(set_blocking(fd, false));
+
+	epoll_event event = {};
+	event.events = handle_events;
+	event.data.ptr = state.get();
+
+	if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) == -1)
+	{
+		std::error_code const error = get_last_error_code();
+
+		if (state->restore_blocking)
+		{
+			(void)set_blocking(fd, true);
+		}
+
+		return allio_ERROR(error);
+	}
+
+	return state.release();
+}
+
+result<void> epoll_multiplexer::deregister_native_handle(native_platform_handle const handle, void* const handle_data)
+{
+	auto const state = static_cast<handle_state*>(handle_data);
+
+	if (state == nullptr)
+	{
+		return {};
+	}
+
+	auto const lock = this->lock(m_mutex);
+
+	(void)epoll_ctl(m_epoll, EPOLL_CTL_DEL, state->fd, nullptr);
+
+	if (state->restore_blocking)
+	{
+		(void)set_blocking(state->fd, true);
+	}
+
+	// Operations still waiting on the handle can never become ready.
+	for (operation_list& waiters : state->waiters)
+	{
+		while (!waiters.empty())
+		{
+			complete(waiters.pop(), error::async_operation_cancelled, m_completion_list);
+		}
+	}
+
+	state->fd = -1;
+
+	if (m_poll_count == 0)
+	{
+		delete state;
+	}
+	else
+	{
+		m_retired_handle_states.push_back(state);
+	}
+
+	return {};
+}
+
+
+result<void> epoll_multiplexer::push(async_operation_storage& storage, handle const& handle, readiness const readiness, perform_callback<>* const perform)
+{
+	auto const state = static_cast<handle_state*>(handle.get_multiplexer_data());
+
+	if (state == nullptr)
+	{
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	storage.m_perform = perform;
+	storage.m_handle_state = state;
+	storage.m_readiness = readiness;
+
+	set_status(storage, async_operation_status::scheduled);
+
+	auto const lock = this->lock(m_mutex);
+	operation_list& waiters = state->waiters[static_cast<size_t>(readiness)];
+
+	// Operations are performed in order, so the operation is attempted right away only if nothing else is waiting.
+	if (waiters.empty())
+	{
+		result<void> const r = perform(storage);
+
+		if (r || !would_block(r.error()))
+		{
+			complete(storage, as_error_code(r), m_completion_list);
+			return {};
+		}
+	}
+
+	waiters.push(storage);
+	set_status(storage, async_operation_status::submitted);
+
+	if (storage.m_deadline != deadline::never())
+	{
+		auto const time_point = storage.m_deadline.is_relative()
+			? deadline::clock::now() + std::chrono::duration_cast<deadline::clock::duration>(storage.m_deadline.relative())
+			: storage.m_deadline.absolute();
+
+		storage.m_timer = m_timers.emplace(time_point, &storage);
+
+		// A poller blocked with the timeout of a later timer would otherwise miss this one.
+		if (*storage.m_timer == m_timers.begin())
+		{
+			wake_poller();
+		}
+	}
+
+	return {};
+}
+
+result<void> epoll_multiplexer::push_work(async_operation_storage& storage, perform_callback<>* const perform)
+{
+	storage.m_perform = perform;
+
+	set_status(storage, async_operation_status::scheduled);
+
+	if (m_workers.empty())
+	{
+		post_synchronous_completion(storage, as_error_code(perform(storage)));
+		return {};
+	}
+
+	{
+		std::unique_lock<std::mutex> const work_lock(m_work_mutex);
+		m_work_list.push(storage);
+	}
+	m_work_condition.notify_one();
+
+	set_status(storage, async_operation_status::submitted);
+
+	return {};
+}
+
+void epoll_multiplexer::post_synchronous_completion(async_operation_storage& storage, std::error_code const result)
+{
+	auto const lock = this->lock(m_mutex);
+	complete(storage, result, m_completion_list);
+}
+
+result<void> epoll_multiplexer::cancel(async_operation_storage& storage)
+{
+	auto const lock = this->lock(m_mutex);
+
+	if (storage.is_completed())
+	{
+		return {};
+	}
+
+	if (handle_state* const state = storage.m_handle_state)
+	{
+		if (state->waiters[static_cast<size_t>(storage.m_readiness)].remove(storage))
+		{
+			complete(storage, error::async_operation_cancelled, m_completion_list);
+		}
+	}
+	else
+	{
+		bool removed;
+		{
+			std::unique_lock<std::mutex> const work_lock(m_work_mutex);
+			removed = m_work_list.remove(storage);
+		}
+
+		if (removed)
+		{
+			complete(storage, error::async_operation_cancelled, m_completion_list);
+		}
+	}
+
+	return {};
+}
+
+
+std::unique_lock<std::mutex> epoll_multiplexer::lock(std::optional<std::mutex>& mutex)
+{
+	if (mutex)
+	{
+		return std::unique_lock<std::mutex>(*mutex);
+	}
+	return std::unique_lock<std::mutex>();
+}
+
+bool epoll_multiplexer::would_block(std::error_code const& error)
+{
+	return error == std::errc::resource_unavailable_try_again || error == std::errc::operation_would_block;
+}
+
+void epoll_multiplexer::work()
+{
+	std::unique_lock<std::mutex> work_lock(m_work_mutex);
+
+	while (true)
+	{
+		m_work_condition.wait(work_lock, [&]()
+		{
+			return m_work_stop || !m_work_list.empty();
+		});
+
+		if (m_work_list.empty())
+		{
+			break;
+		}
+
+		async_operation_storage& storage = m_work_list.pop();
+
+		work_lock.unlock();
+		storage.m_perform_result = as_error_code(storage.m_perform(storage));
+		work_lock.lock();
+
+		// The polling thread drains the event together with the list, so the event is signaled only once per batch.
+		if (m_work_completion_list.empty())
+		{
+			allio_VERIFY(eventfd_write(m_event, 1) != -1);
+		}
+		m_work_completion_list.push(storage);
+	}
+}
+
+void epoll_multiplexer::perform_waiters(operation_list& waiters, operation_list& completion_list)
+{
+	while (!waiters.empty())
+	{
+		async_operation_storage& storage = *waiters.m_head;
+		result<void> const r = storage.m_perform(storage);
+
+		if (!r && would_block(r.error()))
+		{
+			break;
+		}
+
+		(void)waiters.pop();
+		complete(storage, as_error_code(r), completion_list);
+	}
+}
+
+void epoll_multiplexer::complete(async_operation_storage& storage, std::error_code const result, operation_list& completion_list)
+{
+	if (storage.m_timer)
+	{
+		m_timers.erase(*storage.m_timer);
+		storage.m_timer.reset();
+	}
+
+	storage.m_handle_state = nullptr;
+
+	set_result(storage, result);
+
+	async_operation_status new_status =
+		async_operation_status::completed;
+
+	if (result == error::async_operation_cancelled)
+	{
+		new_status |= async_operation_status::cancelled;
+	}
+
+	// Completions posted outside of polling are not noticed by a blocked poller, which is woken once per batch.
+	bool const wake = &completion_list == &m_completion_list &&
+		(storage.get_listener() == nullptr || m_completion_list.empty());
+
+	if (storage.get_listener() != nullptr)
+	{
+		completion_list.push(storage);
+	}
+	else
+	{
+		new_status |= async_operation_status::concluded;
+	}
+
+	set_status(storage, new_status);
+
+	if (wake)
+	{
+		wake_poller();
+	}
+}
+
+void epoll_multiplexer::wake_poller()
+{
+	// Only in concurrent mode can another thread be blocked in epoll_wait.
+	if (m_mutex && m_poll_count != 0)
+	{
+		allio_VERIFY(eventfd_write(m_event, 1) != -1);
+	}
+}
+
+void epoll_multiplexer::expire_timers(deadline::clock::time_point const now, operation_list& completion_list)
+{
+	while (!m_timers.empty() && m_timers.begin()->first <= now)
+	{
+		async_operation_storage& storage = *m_timers.begin()->second;
+
+		allio_VERIFY(storage.m_handle_state->waiters[static_cast<size_t>(storage.m_readiness)].remove(storage));
+		complete(storage, make_error_code(std::errc::timed_out), completion_list);
+	}
+}
+
+void epoll_multiplexer::flush(operation_list& completion_list)
+{
+	while (!completion_list.empty())
+	{
+		async_operation_storage& storage = completion_list.pop();
+
+		set_status(storage, async_operation_status::concluded);
+
+		auto const listener = storage.get_listener();
+		allio_ASSERT(listener != nullptr);
+		listener->completed(storage);
+		listener->concluded(storage);
+	}
+}
+
+allio_TYPE_ID(epoll_multiplexer);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "error.hpp"
+#include "platform_handle.hpp"
+#include <allio/linux/epoll_multiplexer.hpp>
+
+#include <allio/static_multiplexer_handle_relation_provider.hpp>
+
+#include <unistd.h>
+
+#include <allio/linux/detail/undef.i>
+
+namespace allio {
+
+template<std::derived_from<platform_handle> Handle>
+struct multiplexer_handle_implementation<linux::epoll_multiplexer, Handle>
+{
+	static result<void*> register_handle(linux::epoll_multiplexer& m, Handle const& h)
+	{
+		return m.register_native_handle(h.get_platform_handle());
+	}
+
+	static result<void> deregister_handle(linux::epoll_multiplexer& m, Handle const& h)
+	{
+		return m.deregister_native_handle(h.get_platform_handle(), h.get_multiplexer_data());
+	}
+};
+
+template<std::derived_from<platform_handle> Handle>
+struct multiplexer_handle_operation_implementation<linux::epoll_multiplexer, Handle, io::close>
+{
+	using async_operation_storage = linux::epoll_multiplexer::basic_async_operation_storage<io::close>;
+
+	static result<void> start(linux::epoll_multiplexer& m, async_operation_storage& s)
+	{
+		// Releasing the handle removes it from the epoll set and cancels any operations waiting on it.
+		allio_TRY(handle, static_cast<Handle*>(s.handle)->release_native_handle());
+
+		std::error_code result;
+		if (::close(linux::unwrap_handle(handle.handle)) == -1)
+		{
+			result = linux::get_last_error_code();
+		}
+
+		m.post_synchronous_completion(s, result);
+		return {};
+	}
+};
+
+} // namespace allio
+
+#include <allio/linux/detail/undef.i>
@@ -0,0 +1,147 @@
+#include <allio/socket_handle.hpp>
+#include <allio/linux/epoll_multiplexer.hpp>
+
+#include <allio/static_multiplexer_handle_relation_provider.hpp>
+
+#include "epoll_byte_io.hpp"
+#include "epoll_platform_handle.hpp"
+
+#include "../posix_socket.hpp"
+
+#include <allio/linux/detail/undef.i>
+
+using namespace allio;
+using namespace allio::linux;
+
+template<std::derived_from<detail::common_socket_handle_base> Handle>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, Handle, io::socket>
+{
+	using async_operation_storage = epoll_multiplexer::basic_async_operation_storage<io::socket>;
+
+	static constexpr bool synchronous = true;
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		allio_ASSERT(!*s.handle);
+		allio_ASSERT((s.args.handle_flags & flags::multiplexable) != flags::none);
+		allio_TRY(socket, create_socket(s.address_kind, s.args.handle_flags | flags::multiplexable));
+		allio_TRYV(consume_socket_handle(*s.handle, { s.args.handle_flags }, std::move(socket)));
+		m.post_synchronous_completion(s);
+		return {};
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, socket_handle, io::connect>
+{
+	struct async_operation_storage : epoll_multiplexer::basic_async_operation_storage<io::connect>
+	{
+		using basic_async_operation_storage::basic_async_operation_storage;
+
+		socket_address addr;
+		bool connecting = false;
+	};
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		allio_ASSERT(*s.handle);
+		allio_TRYA(s.addr, socket_address::make(s.address));
+
+		return m.push(s, *s.handle, epoll_multiplexer::readiness::write, +[](async_operation_storage& s) -> result<void>
+		{
+			socket_type const socket = unwrap_socket(s.handle->get_platform_handle());
+
+			if (!s.connecting)
+			{
+				if (::connect(socket, &s.addr.addr, s.addr.size) == -1)
+				{
+					if (errno != EINPROGRESS)
+					{
+						return allio_ERROR(get_last_socket_error());
+					}
+
+					// The socket becomes writable once the connection is established or fails.
+					s.connecting = true;
+					return allio_ERROR(make_error_code(std::errc::operation_would_block));
+				}
+
+				return {};
+			}
+
+			int error = 0;
+			socklen_t error_size = sizeof(error);
+
+			if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &error_size) == -1)
+			{
+				return allio_ERROR(get_last_socket_error());
+			}
+
+			if (error != 0)
+			{
+				return allio_ERROR(std::error_code(error, std::system_category()));
+			}
+
+			return {};
+		});
+	}
+
+	static result<void> cancel(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, listen_socket_handle, io::listen>
+{
+	using async_operation_storage = epoll_multiplexer::basic_async_operation_storage<io::listen>;
+
+	static constexpr bool synchronous = true;
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		allio_ASSERT(*s.handle);
+		allio_TRYV(listen_socket(unwrap_socket(s.handle->get_platform_handle()), s.address, s.args));
+		m.post_synchronous_completion(s);
+		return {};
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<epoll_multiplexer, listen_socket_handle, io::accept>
+{
+	struct async_operation_storage : epoll_multiplexer::basic_async_operation_storage<io::accept>
+	{
+		using basic_async_operation_storage::basic_async_operation_storage;
+
+		socket_address addr;
+	};
+
+	static result<void> start(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		// Direct descriptors are specific to io_uring.
+		if ((s.create_args.handle_flags & flags::multiplexer_bound) != flags::none)
+		{
+			return allio_ERROR(make_error_code(std::errc::not_supported));
+		}
+
+		return m.push(s, *s.handle, epoll_multiplexer::readiness::read, +[](async_operation_storage& s) -> result<void>
+		{
+			s.addr.size = sizeof(socket_address_union);
+			allio_TRY(socket, accept_socket(unwrap_socket(s.handle->get_platform_handle()), s.addr, s.create_args));
+
+			allio_ASSERT(!s.result->socket);
+			allio_TRYV(consume_socket_handle(s.result->socket, { s.create_args.handle_flags }, std::move(socket)));
+			s.result->address = s.addr.get_network_address();
+			return {};
+		});
+	}
+
+	static result<void> cancel(epoll_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+allio_MULTIPLEXER_HANDLE_RELATION(epoll_multiplexer, socket_handle);
+allio_MULTIPLEXER_HANDLE_RELATION(epoll_multiplexer, listen_socket_handle);
@@ -1,17 +1,98 @@
 #include <allio/file_handle.hpp>
 
+#include "file_handle.hpp"
+
 #include "api_string.hpp"
 #include "error.hpp"
 #include "filesystem_handle.hpp"
 
 #include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <sys/uio.h>
+#include <unistd.h>
 
 #include <allio/linux/detail/undef.i>
 
 using namespace allio;
 using namespace allio::linux;
 
+result<file_offset> linux::flush_file(int const fd, file_flush_mode const mode, flush_parameters const& args)
+{
+	// Writes completed before the size is sampled are covered by the flush.
+	file_offset size = 0;
+	if (args.sample_size)
+	{
+		struct stat stat;
+		if (fstat(fd, &stat) == -1)
+		{
+			return allio_ERROR(get_last_error_code());
+		}
+		size = static_cast<file_offset>(stat.st_size);
+	}
+
+	if ((mode == file_flush_mode::data ? fdatasync(fd) : fsync(fd)) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return size;
+}
+
+result<file_offset> linux::flush_file_range(int const fd, file_offset const offset, uint64_t const size)
+{
+	unsigned const flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+
+	if (sync_file_range(fd, static_cast<off64_t>(offset), static_cast<off64_t>(size), flags) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return offset + size;
+}
+
+result<int> linux::get_allocation_flags(file_allocation_mode const mode)
+{
+	switch (mode)
+	{
+	case file_allocation_mode::allocate:
+		return 0;
+
+	case file_allocation_mode::keep_size:
+		return FALLOC_FL_KEEP_SIZE;
+
+	case file_allocation_mode::punch_hole:
+		return FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+
+	case file_allocation_mode::zero_range:
+		return FALLOC_FL_ZERO_RANGE;
+	}
+
+	return allio_ERROR(make_error_code(std::errc::invalid_argument));
+}
+
+result<void> linux::allocate_file(int const fd, file_allocation_mode const mode, file_offset const offset, uint64_t const size)
+{
+	allio_TRY(flags, get_allocation_flags(mode));
+
+	if (fallocate(fd, flags, static_cast<off_t>(offset), static_cast<off_t>(size)) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return {};
+}
+
+result<void> linux::set_file_size(int const fd, file_offset const size)
+{
+	if (ftruncate(fd, static_cast<off_t>(size)) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return {};
+}
+
 result<void> detail::file_handle_base::open_sync(filesystem_handle const* const base, path_view const path, file_parameters const& args)
 {
 	allio_ASSERT(!*this);
@@ -54,3 +135,58 @@ result<size_t> detail::file_handle_base::write_at_sync(file_offset const offset,
 
 	return static_cast<size_t>(result);
 }
+
+result<size_t> detail::file_handle_base::transfer_to_sync(file_offset const offset, size_t const size, platform_handle const& target)
+{
+	allio_ASSERT(*this);
+
+	if (is_direct_handle(get_platform_handle()) || is_direct_handle(target.get_platform_handle()))
+	{
+		// Direct descriptors have no file descriptor to transfer from or to.
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	int const source_fd = unwrap_handle(get_platform_handle());
+	int const target_fd = unwrap_handle(target.get_platform_handle());
+
+	off_t sendfile_offset = static_cast<off_t>(offset);
+	ssize_t result = sendfile(target_fd, source_fd, &sendfile_offset, size);
+
+	if (result == -1 && (errno == EINVAL || errno == ENOSYS))
+	{
+		// Some targets, e.g. files opened for appending, are not supported by sendfile.
+		loff_t copy_offset = static_cast<loff_t>(offset);
+		result = copy_file_range(source_fd, &copy_offset, target_fd, nullptr, size, 0);
+	}
+
+	if (result == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return static_cast<size_t>(result);
+}
+
+result<file_offset> detail::file_handle_base::flush_sync(file_flush_mode const mode, flush_parameters const& args)
+{
+	allio_ASSERT(*this);
+	return flush_file(unwrap_handle(get_platform_handle()), mode, args);
+}
+
+result<file_offset> detail::file_handle_base::flush_range_sync(file_offset const offset, uint64_t const size)
+{
+	allio_ASSERT(*this);
+	return flush_file_range(unwrap_handle(get_platform_handle()), offset, size);
+}
+
+result<void> detail::file_handle_base::allocate_sync(file_allocation_mode const mode, file_offset const offset, uint64_t const size)
+{
+	allio_ASSERT(*this);
+	return allocate_file(unwrap_handle(get_platform_handle()), mode, offset, size);
+}
+
+result<void> detail::file_handle_base::set_size_sync(file_offset const size)
+{
+	allio_ASSERT(*this);
+	return set_file_size(unwrap_handle(get_platform_handle()), size);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <allio/file_handle.hpp>
+
+#include <allio/linux/detail/undef.i>
+
+namespace allio::linux {
+
+// Flush the file, returning its size sampled before flushing if requested, otherwise zero.
+result<file_offset> flush_file(int fd, file_flush_mode mode, flush_parameters const& args);
+
+// Write back the range of the file and wait for it, returning the end of the range.
+result<file_offset> flush_file_range(int fd, file_offset offset, uint64_t size);
+
+result<int> get_allocation_flags(file_allocation_mode mode);
+
+result<void> allocate_file(int fd, file_allocation_mode mode, file_offset offset, uint64_t size);
+result<void> set_file_size(int fd, file_offset size);
+
+} // namespace allio::linux
+
+#include <allio/linux/detail/undef.i>
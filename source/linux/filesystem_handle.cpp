@@ -53,11 +53,37 @@ result<open_parameters> open_parameters::make(file_parameters const& args)
 		allio_ERROR(make_error_code(std::errc::not_supported));
 	}
 
+	switch (args.caching)
+	{
+	case file_caching::cached:
+		break;
+
+	case file_caching::write_through:
+		flags |= O_DSYNC;
+		break;
+
+	case file_caching::unbuffered:
+		flags |= O_DIRECT;
+		break;
+
+	case file_caching::unbuffered_write_through:
+		flags |= O_DIRECT | O_DSYNC;
+		break;
+
+	default:
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+
 	return open_parameters{ flags, mode };
 }
 
 result<unique_fd> linux::create_file(filesystem_handle const* const base, path_view const path, file_parameters const& args)
 {
+	if ((args.handle_flags & flags::multiplexer_bound) != flags::none)
+	{
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+
 	allio_TRY(open_args, open_parameters::make(args));
 
 	api_string const path_string = path;
@@ -73,5 +99,22 @@ result<unique_fd> linux::create_file(filesystem_handle const* const base, path_v
 		return allio_ERROR(get_last_error_code());
 	}
 
-	return { result_value, result };
+	unique_fd file(result);
+
+	if (args.allocation_size != 0)
+	{
+		allio_TRYV(preallocate_file(file.get(), args.allocation_size));
+	}
+
+	return { result_value, std::move(file) };
+}
+
+result<void> linux::preallocate_file(int const fd, uint64_t const size)
+{
+	if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size)) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return {};
 }
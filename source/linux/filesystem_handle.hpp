@@ -20,6 +20,9 @@ struct open_parameters
 
 result<unique_fd> create_file(filesystem_handle const* const base, path_view const path, file_parameters const& args);
 
+// Allocate space for a newly opened file according to file_parameters::allocation_size.
+result<void> preallocate_file(int fd, uint64_t size);
+
 } // namespace allio::linux
 
 #include <allio/linux/detail/undef.i>
@@ -28,15 +28,26 @@ struct scatter_gather_async_operation_storage
 	{
 	}
 
-	void init_sqe(io_uring_sqe& sqe, uint8_t const opcode)
+	void init_sqe(io_uring_sqe& sqe, uint8_t const opcode, uint8_t const fixed_opcode)
 	{
 		auto const buffers = this->buffers.buffers();
 
-		sqe.opcode = opcode;
-		sqe.fd = linux::unwrap_handle(static_cast<platform_handle const*>(handle)->get_platform_handle());
+		linux::io_uring_multiplexer::set_file(sqe, *static_cast<platform_handle const*>(handle));
 		sqe.off = offset;
-		sqe.addr = reinterpret_cast<uintptr_t>(buffers.data());
-		sqe.len = buffers.size();
+
+		if (this->buffers.is_registered())
+		{
+			sqe.opcode = fixed_opcode;
+			sqe.addr = reinterpret_cast<uintptr_t>(buffers[0].data());
+			sqe.len = buffers[0].size();
+			sqe.buf_index = this->buffers.registered_index();
+		}
+		else
+		{
+			sqe.opcode = opcode;
+			sqe.addr = reinterpret_cast<uintptr_t>(buffers.data());
+			sqe.len = buffers.size();
+		}
 
 		capture_result([](scatter_gather_async_operation_storage& s, int const result)
 		{
@@ -54,7 +65,7 @@ struct multiplexer_handle_operation_implementation<linux::io_uring_multiplexer,
 	{
 		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
 		{
-			s.init_sqe(sqe, IORING_OP_READV);
+			s.init_sqe(sqe, IORING_OP_READV, IORING_OP_READ_FIXED);
 		});
 	}
 
@@ -73,7 +84,7 @@ struct multiplexer_handle_operation_implementation<linux::io_uring_multiplexer,
 	{
 		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
 		{
-			s.init_sqe(sqe, IORING_OP_WRITEV);
+			s.init_sqe(sqe, IORING_OP_WRITEV, IORING_OP_WRITE_FIXED);
 		});
 	}
 
@@ -92,7 +103,7 @@ struct multiplexer_handle_operation_implementation<linux::io_uring_multiplexer,
 	{
 		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
 		{
-			s.init_sqe(sqe, IORING_OP_READV);
+			s.init_sqe(sqe, IORING_OP_READV, IORING_OP_READ_FIXED);
 		});
 	}
 
@@ -111,7 +122,7 @@ struct multiplexer_handle_operation_implementation<linux::io_uring_multiplexer,
 	{
 		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
 		{
-			s.init_sqe(sqe, IORING_OP_WRITEV);
+			s.init_sqe(sqe, IORING_OP_WRITEV, IORING_OP_WRITE_FIXED);
 		});
 	}
 
@@ -3,12 +3,378 @@
 
 #include <allio/static_multiplexer_handle_relation_provider.hpp>
 
+#include "error.hpp"
+#include "file_handle.hpp"
 #include "io_uring_byte_io.hpp"
 #include "io_uring_filesystem_handle.hpp"
 
+#include <algorithm>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
 #include <allio/linux/detail/undef.i>
 
 using namespace allio;
 using namespace allio::linux;
 
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, allio::file_handle, io::transfer>
+{
+	struct async_operation_storage : io_uring_multiplexer::basic_async_operation_storage<io::transfer>
+	{
+		using basic_async_operation_storage::basic_async_operation_storage;
+
+		io_uring_multiplexer* multiplexer;
+		io_uring_multiplexer::splice_pipe pipe;
+		uint32_t length;
+
+		// Get the fixed file slot of a handle, or -1 if the file descriptor must be used directly.
+		int get_fixed_file(platform_handle const& handle) const
+		{
+			native_platform_handle const native_handle = handle.get_platform_handle();
+
+			if (is_direct_handle(native_handle))
+			{
+				return static_cast<int>(unwrap_direct_handle(native_handle));
+			}
+
+			if (handle.get_multiplexer() != multiplexer)
+			{
+				return -1;
+			}
+			return static_cast<int>(reinterpret_cast<uintptr_t>(handle.get_multiplexer_data())) - 1;
+		}
+
+		// The pipe is released once the operation completes, whether or not it succeeded.
+		// It is empty if everything spliced into it was also spliced out of it.
+		void release_pipe(int const result)
+		{
+			int const link_result = get_link_result();
+			multiplexer->release_splice_pipe(pipe, link_result <= 0 || result == link_result);
+		}
+	};
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		platform_handle const& source = static_cast<platform_handle const&>(*s.handle);
+
+		if ((is_direct_handle(source.get_platform_handle()) && source.get_multiplexer() != &m) ||
+			(is_direct_handle(s.target->get_platform_handle()) && s.target->get_multiplexer() != &m))
+		{
+			// Direct descriptors are only valid in the ring of their own multiplexer.
+			return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+		}
+
+		if (s.size == 0)
+		{
+			*s.result = 0;
+			m.post_synchronous_completion(s);
+			return {};
+		}
+
+		allio_TRYA(s.pipe, m.acquire_splice_pipe());
+		s.multiplexer = &m;
+
+		// Each transfer is limited to the capacity of the pipe. Otherwise the first splice could not complete.
+		s.length = static_cast<uint32_t>(std::min<size_t>(s.size, s.pipe.capacity));
+
+		// The size of the file is not known, so splicing into the pipe may be short or may reach the end of the file.
+		// The splices are hard linked, so that the second splice moves whatever was spliced into the pipe.
+		// The second splice does not block on an empty pipe, which is only possible if the first splice failed or reached the end of the file.
+		s.capture_completion([](async_operation_storage& s, int const result) -> allio::result<void>
+		{
+			s.release_pipe(result);
+
+			if (result >= 0)
+			{
+				*s.result = static_cast<size_t>(result);
+			}
+			else if (result == -EAGAIN && s.get_link_result() == 0)
+			{
+				// The transfer started at or past the end of the file.
+				*s.result = 0;
+			}
+			else
+			{
+				// A failure of the first splice is reported in place of the failure of the second.
+				return allio_ERROR(std::error_code(-result, std::system_category()));
+			}
+
+			return {};
+		});
+
+		auto const r = m.push(s,
+			+[](async_operation_storage& s, io_uring_sqe& sqe)
+			{
+				sqe.opcode = IORING_OP_SPLICE;
+
+				if (int const slot = s.get_fixed_file(static_cast<platform_handle const&>(*s.handle)); slot != -1)
+				{
+					sqe.splice_fd_in = slot;
+					sqe.splice_flags |= SPLICE_F_FD_IN_FIXED;
+				}
+				else
+				{
+					sqe.splice_fd_in = unwrap_handle(static_cast<platform_handle const&>(*s.handle).get_platform_handle());
+				}
+
+				sqe.splice_off_in = s.offset;
+				sqe.fd = s.pipe.write_fd;
+				sqe.off = static_cast<uint64_t>(-1);
+				sqe.len = s.length;
+				sqe.splice_flags |= SPLICE_F_MOVE;
+				sqe.flags |= IOSQE_IO_HARDLINK;
+			},
+			+[](async_operation_storage& s, io_uring_sqe& sqe)
+			{
+				sqe.opcode = IORING_OP_SPLICE;
+				sqe.splice_fd_in = s.pipe.read_fd;
+				sqe.splice_off_in = static_cast<uint64_t>(-1);
+
+				if (int const slot = s.get_fixed_file(*s.target); slot != -1)
+				{
+					sqe.fd = slot;
+					sqe.flags |= IOSQE_FIXED_FILE;
+				}
+				else
+				{
+					sqe.fd = unwrap_handle(s.target->get_platform_handle());
+				}
+
+				sqe.off = static_cast<uint64_t>(-1);
+				sqe.len = s.length;
+				sqe.splice_flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+			});
+
+		if (!r)
+		{
+			// Nothing was submitted, so the pipe is still empty.
+			m.release_splice_pipe(s.pipe, true);
+			return allio_ERROR(r.error());
+		}
+
+		return {};
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, allio::file_handle, io::flush>
+{
+	struct async_operation_storage : io_uring_multiplexer::basic_async_operation_storage<io::flush>
+	{
+		using basic_async_operation_storage::basic_async_operation_storage;
+
+		struct statx stat;
+
+		static void init_flush_sqe(async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			sqe.opcode = IORING_OP_FSYNC;
+			io_uring_multiplexer::set_file(sqe, static_cast<platform_handle const&>(*s.handle));
+
+			if (s.mode == file_flush_mode::data)
+			{
+				sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+			}
+		}
+	};
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		native_platform_handle const handle = static_cast<platform_handle const&>(*s.handle).get_platform_handle();
+
+		// Direct descriptors cannot be used with statx or with synchronous system calls.
+		if (is_direct_handle(handle) && (s.args.sample_size || m.has_completion_polling()))
+		{
+			return allio_ERROR(make_error_code(std::errc::not_supported));
+		}
+
+		if (m.has_completion_polling())
+		{
+			// Only reads and writes complete on a polling multiplexer, so the file is flushed synchronously.
+			allio_TRYA(*s.result, flush_file(unwrap_handle(handle), s.mode, s.args));
+			m.post_synchronous_completion(s);
+			return {};
+		}
+
+		if (!s.args.sample_size)
+		{
+			return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+			{
+				async_operation_storage::init_flush_sqe(s, sqe);
+
+				s.capture_result([](async_operation_storage& s, int const result)
+				{
+					*s.result = 0;
+				});
+			});
+		}
+
+		// The size is sampled by a statx linked before the flush.
+		// In a chain it is performed after the preceding writes, so that the size includes them.
+		return m.push(s,
+			+[](async_operation_storage& s, io_uring_sqe& sqe)
+			{
+				sqe.opcode = IORING_OP_STATX;
+				sqe.fd = unwrap_handle(static_cast<platform_handle const&>(*s.handle).get_platform_handle());
+				sqe.addr = reinterpret_cast<uintptr_t>("");
+				sqe.len = STATX_SIZE;
+				sqe.statx_flags = AT_EMPTY_PATH;
+				sqe.addr2 = reinterpret_cast<uintptr_t>(&s.stat);
+			},
+			+[](async_operation_storage& s, io_uring_sqe& sqe)
+			{
+				async_operation_storage::init_flush_sqe(s, sqe);
+
+				s.capture_result([](async_operation_storage& s, int const result)
+				{
+					*s.result = static_cast<file_offset>(s.stat.stx_size);
+				});
+			});
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, allio::file_handle, io::flush_range>
+{
+	using async_operation_storage = io_uring_multiplexer::basic_async_operation_storage<io::flush_range>;
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		if (s.size == 0 || s.offset + s.size < s.offset)
+		{
+			return allio_ERROR(make_error_code(std::errc::invalid_argument));
+		}
+
+		if (m.has_completion_polling())
+		{
+			native_platform_handle const handle = static_cast<platform_handle const&>(*s.handle).get_platform_handle();
+
+			if (is_direct_handle(handle))
+			{
+				return allio_ERROR(make_error_code(std::errc::not_supported));
+			}
+
+			// Only reads and writes complete on a polling multiplexer, so the range is flushed synchronously.
+			allio_TRYA(*s.result, flush_file_range(unwrap_handle(handle), s.offset, s.size));
+			m.post_synchronous_completion(s);
+			return {};
+		}
+
+		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			sqe.opcode = IORING_OP_SYNC_FILE_RANGE;
+			io_uring_multiplexer::set_file(sqe, static_cast<platform_handle const&>(*s.handle));
+			sqe.off = s.offset;
+
+			// The length is limited to 32 bits. Longer ranges are extended to the end of the file, which zero denotes.
+			sqe.len = s.size <= std::numeric_limits<uint32_t>::max() ? static_cast<uint32_t>(s.size) : 0;
+			sqe.sync_range_flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+
+			s.capture_result([](async_operation_storage& s, int const result)
+			{
+				*s.result = s.offset + s.size;
+			});
+		});
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, allio::file_handle, io::allocate>
+{
+	struct async_operation_storage : io_uring_multiplexer::basic_async_operation_storage<io::allocate>
+	{
+		using basic_async_operation_storage::basic_async_operation_storage;
+
+		int allocation_flags;
+	};
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		allio_TRYA(s.allocation_flags, get_allocation_flags(s.mode));
+
+		if (m.has_completion_polling())
+		{
+			native_platform_handle const handle = static_cast<platform_handle const&>(*s.handle).get_platform_handle();
+
+			if (is_direct_handle(handle))
+			{
+				return allio_ERROR(make_error_code(std::errc::not_supported));
+			}
+
+			// Only reads and writes complete on a polling multiplexer, so the range is allocated synchronously.
+			allio_TRYV(allocate_file(unwrap_handle(handle), s.mode, s.offset, s.size));
+			m.post_synchronous_completion(s);
+			return {};
+		}
+
+		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			sqe.opcode = IORING_OP_FALLOCATE;
+			io_uring_multiplexer::set_file(sqe, static_cast<platform_handle const&>(*s.handle));
+			sqe.off = s.offset;
+			sqe.addr = s.size;
+			sqe.len = static_cast<uint32_t>(s.allocation_flags);
+		});
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, allio::file_handle, io::set_size>
+{
+	using async_operation_storage = io_uring_multiplexer::basic_async_operation_storage<io::set_size>;
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		// IORING_OP_FTRUNCATE requires Linux 6.9, and only reads and writes complete on a polling multiplexer.
+		// Otherwise the size is set synchronously.
+		if (m.has_completion_polling() || !m.supports_opcode(IORING_OP_FTRUNCATE))
+		{
+			native_platform_handle const handle = static_cast<platform_handle const&>(*s.handle).get_platform_handle();
+
+			if (is_direct_handle(handle))
+			{
+				return allio_ERROR(make_error_code(std::errc::not_supported));
+			}
+
+			allio_TRYV(set_file_size(unwrap_handle(handle), s.size));
+			m.post_synchronous_completion(s);
+			return {};
+		}
+
+		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			sqe.opcode = IORING_OP_FTRUNCATE;
+			io_uring_multiplexer::set_file(sqe, static_cast<platform_handle const&>(*s.handle));
+			sqe.off = s.size;
+		});
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
 allio_MULTIPLEXER_HANDLE_RELATION(io_uring_multiplexer, allio::file_handle);
@@ -18,6 +18,20 @@ struct allio::multiplexer_handle_operation_implementation<linux::io_uring_multip
 
 		linux::api_string path_string;
 		linux::open_parameters open_args;
+
+		linux::io_uring_multiplexer* multiplexer;
+
+		// Fixed file slot of a multiplexer bound file, plus one, or IORING_FILE_INDEX_ALLOC.
+		uint32_t file_index = 0;
+
+		static void init_open_sqe(async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			sqe.opcode = IORING_OP_OPENAT;
+			sqe.fd = s.base != nullptr ? linux::unwrap_handle(s.base->get_platform_handle()) : -1;
+			sqe.addr = reinterpret_cast<uintptr_t>(s.path_string.set_string(s.path));
+			sqe.open_flags = s.open_args.flags;
+			sqe.len = s.open_args.mode;
+		}
 	};
 
 	static result<void> start(linux::io_uring_multiplexer& m, async_operation_storage& s)
@@ -26,19 +40,108 @@ struct allio::multiplexer_handle_operation_implementation<linux::io_uring_multip
 
 		allio_TRYA(s.open_args, linux::open_parameters::make(s.args));
 
+		s.multiplexer = &m;
+
+		if (m.has_completion_polling())
+		{
+			// Only reads and writes complete on a polling multiplexer, so the file is opened synchronously.
+			allio_TRY(file, linux::create_file(s.base, s.path, s.args));
+			allio_TRYV(linux::consume_platform_handle(static_cast<Handle&>(*s.handle), { s.args.handle_flags }, std::move(file)));
+			m.post_synchronous_completion(s);
+			return {};
+		}
+
+		// Preallocation is linked after the open, which requires the slot to be known up front.
+		bool const preallocate = s.args.allocation_size != 0;
+
+		if ((s.args.handle_flags & flags::multiplexer_bound) != flags::none && m.has_direct_file_allocation() && !m.is_chaining() && !preallocate)
+		{
+			// The kernel allocates a slot for the file, which is attached to the handle on completion.
+			// The file never enters the process file descriptor table.
+			s.file_index = IORING_FILE_INDEX_ALLOC;
+		}
+		else if ((s.args.handle_flags & flags::multiplexer_bound) != flags::none)
+		{
+			// The file is opened directly into a fixed file slot, which is attached to the handle up front.
+			// This allows operations later in the same chain to refer to the file before the open completes.
+			// If the open fails, the handle still holds the slot and must be closed.
+			allio_TRY(slot, m.acquire_file_slot());
+
+			result<void> const r = static_cast<Handle&>(*s.handle).set_native_handle(
+			{
+				platform_handle::native_handle_type
+				{
+					{ s.args.handle_flags },
+					linux::wrap_direct_handle(slot),
+				},
+			});
+
+			if (!r)
+			{
+				m.release_file_slot(slot);
+				return allio_ERROR(r.error());
+			}
+
+			s.file_index = slot + 1;
+
+			if (preallocate)
+			{
+				// The file is allocated by a fallocate linked after the open into the slot.
+				return m.push(s,
+					+[](async_operation_storage& s, io_uring_sqe& sqe)
+					{
+						async_operation_storage::init_open_sqe(s, sqe);
+						sqe.file_index = s.file_index;
+					},
+					+[](async_operation_storage& s, io_uring_sqe& sqe)
+					{
+						sqe.opcode = IORING_OP_FALLOCATE;
+						sqe.fd = static_cast<int>(s.file_index - 1);
+						sqe.flags |= IOSQE_FIXED_FILE;
+						sqe.off = 0;
+						sqe.addr = s.args.allocation_size;
+						sqe.len = FALLOC_FL_KEEP_SIZE;
+					});
+			}
+		}
+
 		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
 		{
-			sqe.opcode = IORING_OP_OPENAT;
-			sqe.fd = s.base != nullptr ? linux::unwrap_handle(s.base->get_platform_handle()) : -1;
-			sqe.addr = reinterpret_cast<uintptr_t>(s.path_string.set_string(s.path));
-			sqe.open_flags = s.open_args.flags;
-			sqe.len = s.open_args.mode;
+			async_operation_storage::init_open_sqe(s, sqe);
+
+			if (s.file_index == IORING_FILE_INDEX_ALLOC)
+			{
+				sqe.file_index = IORING_FILE_INDEX_ALLOC;
+
+				s.capture_result([](async_operation_storage& s, int const result) -> allio::result<void>
+				{
+					allio_ASSERT(!*s.handle);
+					return linux::consume_direct_handle(*s.multiplexer,
+						static_cast<Handle&>(*s.handle), { s.args.handle_flags }, static_cast<uint32_t>(result));
+				});
+
+				return;
+			}
+
+			if (s.file_index != 0)
+			{
+				sqe.file_index = s.file_index;
+				return;
+			}
 
 			s.capture_result([](async_operation_storage& s, int const result) -> allio::result<void>
 			{
 				allio_ASSERT(!*s.handle);
+				linux::unique_fd file(result);
+
+				// The descriptor is not known until the open completes, so the file is preallocated synchronously.
+				if (s.args.allocation_size != 0)
+				{
+					allio_TRYV(linux::preallocate_file(file.get(), s.args.allocation_size));
+				}
+
 				return linux::consume_platform_handle(
-					static_cast<Handle&>(*s.handle), { s.args.handle_flags }, linux::unique_fd(result));
+					static_cast<Handle&>(*s.handle), { s.args.handle_flags }, std::move(file));
 			});
 		});
 	}
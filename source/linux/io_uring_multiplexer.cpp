@@ -5,23 +5,19 @@
 
 #include "error.hpp"
 #include "../async_handle_types.hpp"
+#include "../atomic_spin_hint.hpp"
 
+#include <algorithm>
 #include <bit>
 
 #include <cstring>
+#include <limits>
+#include <memory>
 
-#if __has_include(<linux/time64.h>)
-#	include <linux/time64.h>
-#else
-struct timespec64
-{
-	uint64_t tv_sec;
-	long tv_nsec;
-};
-#endif
-
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/syscall.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <allio/linux/detail/undef.i>
@@ -31,6 +27,8 @@ using namespace allio::linux;
 
 allio_EXTERN_ASYNC_HANDLE_MULTIPLEXER_RELATIONS(io_uring_multiplexer);
 
+thread_local io_uring_multiplexer::chain_context io_uring_multiplexer::s_chain;
+
 namespace {
 
 static int io_uring_setup(unsigned const entries, io_uring_params* const p)
@@ -43,6 +41,11 @@ static int io_uring_enter(int const fd, unsigned const to_submit, unsigned const
 	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
 }
 
+static int io_uring_register(int const fd, unsigned const opcode, void const* const arg, unsigned const nr_args)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
 
 static constexpr uintptr_t user_data_tag_mask = alignof(io_uring_multiplexer::async_operation_storage) - 1;
 static constexpr uintptr_t user_data_ptr_mask = ~user_data_tag_mask;
@@ -51,6 +54,11 @@ enum : uintptr_t
 {
 	user_data_normal,
 	user_data_cancel,
+	user_data_timeout,
+	user_data_link,
+	user_data_message,
+	user_data_descriptor,
+	user_data_enter_timeout,
 
 	user_data_n
 };
@@ -64,6 +72,16 @@ static bool wrap_lt(uint32_t const lhs, uint32_t const rhs)
 	return rhs - lhs < 0x80000000;
 }
 
+static __kernel_timespec make_timespec(std::chrono::nanoseconds const duration)
+{
+	auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+
+	__kernel_timespec timespec = {};
+	timespec.tv_sec = seconds.count();
+	timespec.tv_nsec = (duration - seconds).count();
+	return timespec;
+}
+
 static size_t get_sqe_shift(uint32_t const flags)
 {
 	return (flags & IORING_SETUP_SQE128) != 0;
@@ -92,6 +110,33 @@ void io_uring_multiplexer::mmapping_deleter::release(void* const addr, size_t co
 	}
 }
 
+io_uring_multiplexer::resource_table::resource_table(uint32_t const size)
+	: m_free_list(std::make_unique<uint32_t[]>(size))
+	, m_size(size)
+	, m_free_count(size)
+{
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		m_free_list[i] = size - i - 1;
+	}
+}
+
+result<uint32_t> io_uring_multiplexer::resource_table::acquire()
+{
+	if (m_free_count == 0)
+	{
+		return allio_ERROR(make_error_code(std::errc::too_many_files_open));
+	}
+	return m_free_list[--m_free_count];
+}
+
+void io_uring_multiplexer::resource_table::release(uint32_t const index)
+{
+	allio_ASSERT(index < m_size);
+	allio_ASSERT(m_free_count < m_size);
+	m_free_list[m_free_count++] = index;
+}
+
 template<auto Next>
 void io_uring_multiplexer::defer_list<Next>::defer(async_operation_storage* const storage)
 {
@@ -141,8 +186,8 @@ void io_uring_multiplexer::defer_list<Next>::flush(auto&& fn)
 
 struct io_uring_multiplexer::defer_context
 {
-	defer_list<&async_operation_storage::m_next_submitted> submitted_list;
 	defer_list<&async_operation_storage::m_next_completed> completed_list;
+	defer_list<&async_operation_storage::m_next_yielded> yielded_list;
 
 	defer_context() = default;
 
@@ -151,11 +196,14 @@ struct io_uring_multiplexer::defer_context
 
 	~defer_context()
 	{
-		submitted_list.flush([](async_operation_storage& storage)
+		yielded_list.flush([](async_operation_storage& storage)
 		{
 			auto const listener = storage.get_listener();
 			allio_ASSERT(listener != nullptr);
-			listener->submitted(storage);
+			listener->yielded(storage);
+
+			// The next completion of the operation may now reuse its result storage.
+			storage.m_yield_pending.store(false, std::memory_order_release);
 		});
 
 		completed_list.flush([](async_operation_storage& storage)
@@ -182,24 +230,103 @@ result<io_uring_multiplexer::init_result> io_uring_multiplexer::init(init_option
 		return static_cast<uint32_t>(1) << (31 - lz);
 	};
 
-	allio_TRY(min_entries, round_up_to_po2(std::max(static_cast<uint32_t>(32),
-		std::max(options.min_submission_queue_size, options.min_completion_queue_size))));
+	allio_TRY(sq_entries, round_up_to_po2(std::max(static_cast<uint32_t>(32), options.min_submission_queue_size)));
+	allio_TRY(cq_entries, round_up_to_po2(std::max(sq_entries * 2, options.min_completion_queue_size)));
 
 	io_uring_params params = {};
 
+	if (cq_entries != sq_entries * 2)
+	{
+		params.flags |= IORING_SETUP_CQSIZE;
+		params.cq_entries = cq_entries;
+	}
+
 	if (options.enable_kernel_polling_thread)
 	{
 		params.flags |= IORING_SETUP_SQPOLL;
 
 		if (options.share_kernel_polling_thread != nullptr)
 		{
+			// The attached ring uses the existing polling thread, whose affinity and idle time are already set.
+			if (options.kernel_polling_thread_cpu || options.kernel_polling_thread_idle_time != std::chrono::milliseconds::zero())
+			{
+				return allio_ERROR(make_error_code(std::errc::invalid_argument));
+			}
+
+			params.flags |= IORING_SETUP_ATTACH_WQ;
 			params.wq_fd = options.share_kernel_polling_thread->m_io_uring;
 		}
+
+		if (options.kernel_polling_thread_cpu)
+		{
+			params.flags |= IORING_SETUP_SQ_AFF;
+			params.sq_thread_cpu = *options.kernel_polling_thread_cpu;
+		}
+
+		if (options.kernel_polling_thread_idle_time != std::chrono::milliseconds::zero())
+		{
+			if (options.kernel_polling_thread_idle_time < std::chrono::milliseconds::zero() ||
+				options.kernel_polling_thread_idle_time.count() > std::numeric_limits<uint32_t>::max())
+			{
+				return allio_ERROR(make_error_code(std::errc::argument_out_of_domain));
+			}
+
+			params.sq_thread_idle = static_cast<uint32_t>(options.kernel_polling_thread_idle_time.count());
+		}
+	}
+	else if (options.kernel_polling_thread_cpu || options.kernel_polling_thread_idle_time != std::chrono::milliseconds::zero())
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	if (options.enable_single_issuer)
+	{
+		if (options.enable_concurrent_submission || options.enable_concurrent_completion || options.enable_lock_free_submission)
+		{
+			return allio_ERROR(make_error_code(std::errc::invalid_argument));
+		}
+
+		params.flags |= IORING_SETUP_SINGLE_ISSUER;
+	}
+
+	if (options.enable_deferred_task_running)
+	{
+		if (!options.enable_single_issuer || options.enable_kernel_polling_thread)
+		{
+			return allio_ERROR(make_error_code(std::errc::invalid_argument));
+		}
+
+		params.flags |= IORING_SETUP_DEFER_TASKRUN;
+	}
+
+	if (options.enable_cooperative_task_running)
+	{
+		params.flags |= IORING_SETUP_COOP_TASKRUN;
+	}
+
+	if (options.enable_completion_polling)
+	{
+		params.flags |= IORING_SETUP_IOPOLL;
+	}
+
+	if (options.enable_task_running_flag)
+	{
+		if (!options.enable_cooperative_task_running && !options.enable_deferred_task_running)
+		{
+			return allio_ERROR(make_error_code(std::errc::invalid_argument));
+		}
+
+		params.flags |= IORING_SETUP_TASKRUN_FLAG;
+	}
+
+	if (options.completion_worker_count != 0 && !options.enable_concurrent_completion)
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
 	}
 
 	allio_TRY(io_uring, [&]() -> result<detail::unique_fd>
 	{
-		int const io_uring = io_uring_setup(min_entries, &params);
+		int const io_uring = io_uring_setup(sq_entries, &params);
 
 		if (io_uring == -1)
 		{
@@ -209,6 +336,12 @@ result<io_uring_multiplexer::init_result> io_uring_multiplexer::init(init_option
 		return { result_value, io_uring };
 	}());
 
+	if (options.enable_lock_free_submission && (params.features & IORING_FEAT_EXT_ARG) == 0)
+	{
+		// Without EXT_ARG timed waits push a timeout into the submission queue, which requires exclusive access.
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+
 
 	auto const mmap_r = [&](size_t const size, uint64_t const offset) -> result<unique_mmapping>
 	{
@@ -258,12 +391,100 @@ result<io_uring_multiplexer::init_result> io_uring_multiplexer::init(init_option
 	allio_TRY(sqes, mmap_r(params.sq_entries * get_sqe_size(params.flags), IORING_OFF_SQES));
 
 
+	if (options.buffer_table_size != 0)
+	{
+		io_uring_rsrc_register const rsrc_register =
+		{
+			.nr = options.buffer_table_size,
+			.flags = IORING_RSRC_REGISTER_SPARSE,
+		};
+
+		if (io_uring_register(io_uring.get(), IORING_REGISTER_BUFFERS2, &rsrc_register, sizeof(rsrc_register)) == -1)
+		{
+			return allio_ERROR(get_last_error_code());
+		}
+	}
+
+
+	if (uint32_t const file_table_size = options.file_table_size + options.direct_file_table_size; file_table_size != 0)
+	{
+		io_uring_rsrc_register const rsrc_register =
+		{
+			.nr = file_table_size,
+			.flags = IORING_RSRC_REGISTER_SPARSE,
+		};
+
+		if (io_uring_register(io_uring.get(), IORING_REGISTER_FILES2, &rsrc_register, sizeof(rsrc_register)) == -1)
+		{
+			if (errno != EINVAL)
+			{
+				return allio_ERROR(get_last_error_code());
+			}
+
+			// Kernels without sparse registration accept a table of empty slots.
+			auto const fds = std::make_unique<int[]>(file_table_size);
+			std::fill_n(fds.get(), file_table_size, -1);
+
+			if (io_uring_register(io_uring.get(), IORING_REGISTER_FILES, fds.get(), file_table_size) == -1)
+			{
+				return allio_ERROR(get_last_error_code());
+			}
+		}
+	}
+
+	if (options.direct_file_table_size != 0)
+	{
+		// Restrict kernel allocation to the slots following those managed by the multiplexer.
+		io_uring_file_index_range const range =
+		{
+			.off = options.file_table_size,
+			.len = options.direct_file_table_size,
+		};
+
+		if (io_uring_register(io_uring.get(), IORING_REGISTER_FILE_ALLOC_RANGE, &range, 0) == -1)
+		{
+			return allio_ERROR(get_last_error_code());
+		}
+	}
+
+
+	std::bitset<256> supported_opcodes;
+	{
+		static constexpr size_t probe_op_count = 256;
+
+		// The storage is zeroed and suitably aligned for the probe.
+		auto const probe_storage = std::make_unique<std::byte[]>(sizeof(io_uring_probe) + probe_op_count * sizeof(io_uring_probe_op));
+		auto const probe = reinterpret_cast<io_uring_probe*>(probe_storage.get());
+
+		// Probing requires Linux 5.6. Older kernels are treated as supporting none of the probed opcodes.
+		if (io_uring_register(io_uring.get(), IORING_REGISTER_PROBE, probe, probe_op_count) != -1)
+		{
+			for (uint32_t i = 0; i < probe->ops_len; ++i)
+			{
+				if ((probe->ops[i].flags & IO_URING_OP_SUPPORTED) != 0)
+				{
+					supported_opcodes.set(probe->ops[i].op);
+				}
+			}
+		}
+	}
+
+
 	result<init_result> result = { result_value };
 	result->params = params;
 	result->io_uring = std::move(io_uring);
 	result->sq_ring = std::move(sq_ring);
 	result->cq_ring = std::move(cq_ring);
 	result->sqes = std::move(sqes);
+	result->buffer_table = resource_table(options.buffer_table_size);
+	result->file_table = resource_table(options.file_table_size);
+	result->direct_file_table_size = options.direct_file_table_size;
+	result->supported_opcodes = supported_opcodes;
+	result->enable_concurrent_submission = options.enable_concurrent_submission || options.enable_lock_free_submission;
+	result->enable_concurrent_completion = options.enable_concurrent_completion;
+	result->enable_lock_free_submission = options.enable_lock_free_submission;
+	result->completion_worker_count = options.completion_worker_count;
+	result->defer_submission = options.defer_submission;
 	return result;
 }
 
@@ -283,6 +504,21 @@ io_uring_multiplexer::io_uring_multiplexer(init_result&& resources)
 
 	m_flags = params.flags;
 	m_features = params.features;
+	m_supported_opcodes = resources.supported_opcodes;
+
+	m_defer_submission = resources.defer_submission;
+	m_lock_free_submission = resources.enable_lock_free_submission;
+
+	// In lock-free mode the mutex still guards the resource tables.
+	if (resources.enable_concurrent_submission)
+	{
+		m_sq_mutex.emplace();
+	}
+
+	if (resources.enable_concurrent_completion)
+	{
+		m_cq_mutex.emplace();
+	}
 
 	m_sq_k_produce = reinterpret_cast<uint32_t*>(m_sq_mmap_addr + params.sq_off.tail);
 	m_sq_k_consume = reinterpret_cast<uint32_t*>(m_sq_mmap_addr + params.sq_off.head);
@@ -298,13 +534,34 @@ io_uring_multiplexer::io_uring_multiplexer(init_result&& resources)
 	m_sq_size = params.sq_entries;
 	m_cq_size = params.cq_entries;
 
+	m_buffer_table = std::move(resources.buffer_table);
+	m_file_table = std::move(resources.file_table);
+	m_direct_file_table_size = resources.direct_file_table_size;
+
+	m_completion_worker_count = resources.completion_worker_count;
+	m_completion_worker_next = 0;
+	m_completion_reap_generation.store(0, std::memory_order_relaxed);
+
+	if (m_completion_worker_count != 0)
+	{
+		m_completion_workers = std::make_unique<completion_worker[]>(m_completion_worker_count);
+	}
+
 	m_synchronous_completion_count = 0;
 
 	m_sq_cq_available = params.cq_entries;
+	m_sq_cq_overcommit = 0;
 	m_sq_acquire = *m_sq_k_consume - m_sq_size;
-	m_sq_release = m_sq_acquire;
-	m_sq_submit = m_sq_acquire;
+	m_sq_release = *m_sq_k_produce;
+	m_sq_submit = *m_sq_k_produce;
+
+	// In lock-free mode CQEs are acquired directly from the shared counter.
+	m_cq_cq_available.store(m_lock_free_submission ? params.cq_entries : 0, std::memory_order_relaxed);
+	m_sq_flushing.store(false, std::memory_order_relaxed);
+	m_sq_enter_timeout_free = nullptr;
+	m_cq_enter_timeout_free.store(nullptr, std::memory_order_relaxed);
 
+	// In lock-free mode the array is never changed, so the entry at each position of the ring is fixed.
 	for (size_t i = 0; i < m_sq_size; ++i)
 	{
 		m_sq_k_array[m_sq_acquire + i & m_sq_size - 1] = i;
@@ -313,6 +570,12 @@ io_uring_multiplexer::io_uring_multiplexer(init_result&& resources)
 
 io_uring_multiplexer::~io_uring_multiplexer()
 {
+	for (splice_pipe const& pipe : m_splice_pipes)
+	{
+		detail::fd_deleter::release(pipe.read_fd);
+		detail::fd_deleter::release(pipe.write_fd);
+	}
+
 	mmapping_deleter::release(m_sqes, m_sq_size * get_sqe_size(m_flags));
 	mmapping_deleter::release(m_sq_mmap_addr, m_sq_mmap_size);
 	mmapping_deleter::release(m_cq_mmap_addr, m_cq_mmap_size);
@@ -332,6 +595,12 @@ result<multiplexer_handle_relation const*> io_uring_multiplexer::find_handle_rel
 result<void> io_uring_multiplexer::submit(deadline const deadline)
 {
 	defer_context defer_context;
+
+	if (m_lock_free_submission)
+	{
+		return flush_lock_free_submissions(defer_context);
+	}
+
 	auto const sq_lock = lock(m_sq_mutex);
 	return enter(defer_context, true, false, deadline);
 }
@@ -339,138 +608,895 @@ result<void> io_uring_multiplexer::submit(deadline const deadline)
 result<void> io_uring_multiplexer::poll(deadline const deadline)
 {
 	defer_context defer_context;
+
+	// Without EXT_ARG a timed wait pushes a timeout into the submission queue.
+	std::unique_lock<std::mutex> sq_lock;
+	if ((m_features & IORING_FEAT_EXT_ARG) == 0 && deadline != deadline::instant() && deadline != deadline::never())
+	{
+		allio_ASSERT(!m_lock_free_submission);
+		sq_lock = lock(m_sq_mutex);
+	}
+
 	auto const cq_lock = lock(m_cq_mutex);
-	return enter(defer_context, false, true, deadline);
+	allio_TRYV(enter(defer_context, false, true, deadline));
+	distribute_completions(defer_context);
+	return {};
 }
 
 result<void> io_uring_multiplexer::submit_and_poll(deadline const deadline)
 {
 	defer_context defer_context;
-	auto const sq_lock = lock(m_sq_mutex);
-	auto const cq_lock = lock(m_cq_mutex);
-	return enter(defer_context, true, true, deadline);
-}
 
-result<void*> io_uring_multiplexer::register_native_handle(native_platform_handle const handle)
-{
-	return nullptr;
-}
+	if (m_lock_free_submission)
+	{
+		allio_TRYV(flush_lock_free_submissions(defer_context));
 
-result<void> io_uring_multiplexer::deregister_native_handle(native_platform_handle const handle)
-{
+		auto const cq_lock = lock(m_cq_mutex);
+		allio_TRYV(enter(defer_context, false, true, deadline));
+		distribute_completions(defer_context);
+		return {};
+	}
+
+	auto const sq_lock = lock(m_sq_mutex);
+	auto const cq_lock = lock(m_cq_mutex);
+	allio_TRYV(enter(defer_context, true, true, deadline));
+	distribute_completions(defer_context);
 	return {};
 }
 
-result<void> io_uring_multiplexer::push_internal(async_operation_storage& storage, auto&& init_sqe)
+result<void> io_uring_multiplexer::poll_completion_worker(uint32_t const worker_index, deadline deadline)
 {
-	defer_context defer_context;
-	auto const sq_lock = lock(m_sq_mutex);
-
-	allio_ASSERT(!storage.is_scheduled());
-
-	allio_TRY(sqe_index, acquire_sqe());
-	init_sqe(use_sqe(sqe_index));
-	release_sqe(sqe_index);
-
-	set_status(storage, async_operation_status::scheduled);
-
-	if (true) //TODO: enable control of automatic submission somehow
+	if (worker_index >= m_completion_worker_count)
 	{
-		allio_TRYV(enter(defer_context, true, false, deadline::instant()));
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
 	}
-	else if ((m_flags & IORING_SETUP_SQPOLL) != 0)
+
+	completion_worker& worker = m_completion_workers[worker_index];
+
+	// The deadline is measured from the start of the call, across any number of waits.
+	if (deadline.is_relative() && deadline != deadline::instant())
 	{
-		flush_submission_queue(defer_context);
+		deadline = deadline::clock::now() + std::chrono::duration_cast<deadline::clock::duration>(deadline.relative());
 	}
 
-	return {};
-}
-
-result<void> io_uring_multiplexer::push(async_operation_storage& storage, init_sqe_callback<>* const init_sqe)
-{
-	return push_internal(storage, [&](io_uring_sqe& sqe)
+	while (!run_completions(worker))
 	{
-		init_sqe(storage, sqe);
+		uint32_t const generation = m_completion_reap_generation.load(std::memory_order_seq_cst);
 
-		allio_ASSERT(sqe.user_data == 0);
-		sqe.user_data = reinterpret_cast<uintptr_t>(&storage);
+		// Without EXT_ARG a timed wait pushes a timeout into the submission queue, as in poll.
+		// The submission lock is taken before the completion lock, in the same order as poll.
+		std::unique_lock<std::mutex> sq_lock;
+		if ((m_features & IORING_FEAT_EXT_ARG) == 0 && deadline != deadline::instant() && deadline != deadline::never())
+		{
+			sq_lock = lock(m_sq_mutex);
+		}
 
-		if (storage.get_listener() != nullptr)
+		if (std::unique_lock<std::mutex> cq_lock(*m_cq_mutex, std::try_to_lock); cq_lock)
 		{
-			m_submitted_list.defer(&storage);
+			result<void> r;
+			{
+				// Intermediate results are delivered once the locks have been released.
+				defer_context defer_context;
+				r = enter(defer_context, false, true, deadline);
+				distribute_completions(defer_context);
+				cq_lock.unlock();
+
+				if (sq_lock)
+				{
+					sq_lock.unlock();
+				}
+			}
+
+			// Let a waiting worker take over reaping.
+			notify_completion_workers();
+
+			if (!r)
+			{
+				return r;
+			}
+
+			if (run_completions(worker) || deadline.remaining() == std::chrono::nanoseconds::zero())
+			{
+				break;
+			}
 		}
-	});
-}
+		else
+		{
+			// Submissions are not held up while waiting.
+			if (sq_lock)
+			{
+				sq_lock.unlock();
+			}
 
-void io_uring_multiplexer::post_synchronous_completion(async_operation_storage& storage, int const result)
-{
-	set_result(storage, as_error_code(storage.set_result(result)));
-	set_status(storage,
-		async_operation_status::completed |
-		async_operation_status::concluded);
+			// Another thread is reaping. Wait for it to hand over completions or to stop reaping.
+			std::unique_lock<std::mutex> lock(worker.m_mutex);
+			worker.m_waiting.store(true, std::memory_order_seq_cst);
 
-	if (storage.get_listener() != nullptr)
-	{
-		++m_synchronous_completion_count;
-		m_synchronous_completion_list.defer(&storage);
+			auto const predicate = [&]()
+			{
+				return worker.m_head.load(std::memory_order_seq_cst) != nullptr ||
+					m_completion_reap_generation.load(std::memory_order_seq_cst) != generation;
+			};
+
+			bool ready = true;
+			if (deadline == deadline::never())
+			{
+				worker.m_condition.wait(lock, predicate);
+			}
+			else
+			{
+				ready = worker.m_condition.wait_until(lock, deadline.is_absolute() ? deadline.absolute() : deadline::clock::now(), predicate);
+			}
+
+			worker.m_waiting.store(false, std::memory_order_relaxed);
+
+			if (!ready)
+			{
+				break;
+			}
+		}
 	}
+
+	return {};
 }
 
-result<void> io_uring_multiplexer::cancel(async_operation_storage& storage)
+result<void*> io_uring_multiplexer::register_native_handle(native_platform_handle const handle)
 {
-	return push_internal(storage, [&](io_uring_sqe& sqe)
+	if (is_direct_handle(handle))
 	{
-		sqe.opcode = IORING_OP_ASYNC_CANCEL;
-		sqe.addr = reinterpret_cast<uintptr_t>(&storage);
-		sqe.user_data = reinterpret_cast<uintptr_t>(&storage) | user_data_cancel;
-	});
-}
+		// Direct descriptors already occupy their slot in the fixed file table.
+		return reinterpret_cast<void*>(static_cast<uintptr_t>(unwrap_direct_handle(handle)) + 1);
+	}
 
-std::unique_lock<std::mutex> io_uring_multiplexer::lock(std::optional<std::mutex>& mutex)
-{
-	if (mutex)
+	auto const sq_lock = lock(m_sq_mutex);
+
+	if (m_file_table.size() == 0)
 	{
-		return std::unique_lock<std::mutex>(*mutex);
+		return nullptr;
 	}
-	return std::unique_lock<std::mutex>();
-}
 
-io_uring_sqe& io_uring_multiplexer::use_sqe(uint32_t const sqe_index)
-{
-	io_uring_sqe& sqe = m_sqes[sqe_index];
-	memset(&sqe, 0, sizeof(sqe) << get_sqe_shift(m_flags));
-	return sqe;
-}
+	auto const index = m_file_table.acquire();
 
-result<uint32_t> io_uring_multiplexer::acquire_sqe()
-{
-	allio_TRYV(acquire_cqe());
+	if (!index)
+	{
+		// Operations on handles without a slot use the file descriptor directly.
+		return nullptr;
+	}
 
-	auto const sq_k_consume = std::atomic_ref(*m_sq_k_consume);
+	int const fd = unwrap_handle(handle);
 
-	uint32_t const sq_consume = sq_k_consume.load(std::memory_order_relaxed);
-	uint32_t const sq_acquire = m_sq_acquire;
+	io_uring_rsrc_update const update =
+	{
+		.offset = *index,
+		.data = reinterpret_cast<uintptr_t>(&fd),
+	};
 
-	if (sq_acquire == sq_consume)
+	if (io_uring_register(m_io_uring, IORING_REGISTER_FILES_UPDATE, &update, 1) == -1)
 	{
-		++m_sq_cq_available; // Release previously acquired CQE.
-		return allio_ERROR(error::too_many_concurrent_async_operations);
+		std::error_code const error = get_last_error_code();
+		m_file_table.release(*index);
+		return allio_ERROR(error);
 	}
 
-	m_sq_acquire = sq_acquire + 1;
-	return m_sq_k_array[sq_acquire & m_sq_size - 1];
+	return reinterpret_cast<void*>(static_cast<uintptr_t>(*index) + 1);
 }
 
-void io_uring_multiplexer::release_sqe(uint32_t const sqe_index)
+result<void> io_uring_multiplexer::deregister_native_handle(native_platform_handle const handle, void* const handle_data)
 {
-	uint32_t const sq_release = m_sq_release++;
-	m_sq_k_array[sq_release & m_sq_size - 1] = sqe_index;
-
-	if ((m_flags & IORING_SETUP_SQPOLL) != 0)
+	if (handle_data == nullptr)
 	{
-		auto const sq_k_produce = std::atomic_ref(*m_sq_k_produce);
-		sq_k_produce.store(sq_release, std::memory_order_release);
+		return {};
 	}
+
+	auto const sq_lock = lock(m_sq_mutex);
+
+	uint32_t const index = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(handle_data) - 1);
+
+	int const fd = -1;
+
+	io_uring_rsrc_update const update =
+	{
+		.offset = index,
+		.data = reinterpret_cast<uintptr_t>(&fd),
+	};
+
+	if (io_uring_register(m_io_uring, IORING_REGISTER_FILES_UPDATE, &update, 1) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	// Slots allocated by the kernel are freed by clearing them.
+	if (index < m_file_table.size())
+	{
+		m_file_table.release(index);
+	}
+
+	return {};
+}
+
+result<registered_buffer> io_uring_multiplexer::register_buffer(std::span<std::byte> const memory)
+{
+	auto const sq_lock = lock(m_sq_mutex);
+
+	allio_TRY(index, m_buffer_table.acquire());
+
+	iovec const buffer =
+	{
+		.iov_base = memory.data(),
+		.iov_len = memory.size(),
+	};
+
+	io_uring_rsrc_update2 const update =
+	{
+		.offset = index,
+		.data = reinterpret_cast<uintptr_t>(&buffer),
+		.nr = 1,
+	};
+
+	if (io_uring_register(m_io_uring, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) == -1)
+	{
+		std::error_code const error = get_last_error_code();
+		m_buffer_table.release(index);
+		return allio_ERROR(error);
+	}
+
+	return { result_value, memory.data(), memory.size(), index };
+}
+
+result<void> io_uring_multiplexer::deregister_buffer(registered_buffer const buffer)
+{
+	auto const sq_lock = lock(m_sq_mutex);
+
+	allio_ASSERT(buffer);
+
+	iovec const empty_buffer = {};
+
+	io_uring_rsrc_update2 const update =
+	{
+		.offset = buffer.index(),
+		.data = reinterpret_cast<uintptr_t>(&empty_buffer),
+		.nr = 1,
+	};
+
+	if (io_uring_register(m_io_uring, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	m_buffer_table.release(buffer.index());
+	return {};
+}
+
+provided_buffer io_uring_multiplexer::buffer_group::get_buffer(uint32_t const cqe_flags, size_t const size) const
+{
+	if ((cqe_flags & IORING_CQE_F_BUFFER) == 0)
+	{
+		return {};
+	}
+
+	uint16_t const index = static_cast<uint16_t>(cqe_flags >> IORING_CQE_BUFFER_SHIFT);
+	allio_ASSERT(index < m_buffer_count);
+
+	return
+	{
+		.data = m_buffers.get() + static_cast<size_t>(index) * m_buffer_size,
+		.size = size,
+		.group = m_id,
+		.index = index,
+	};
+}
+
+result<uint16_t> io_uring_multiplexer::create_buffer_group(uint32_t const buffer_count, size_t const buffer_size)
+{
+	if (buffer_count == 0 || buffer_count > 0x8000 || (buffer_count & buffer_count - 1) != 0)
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	if (buffer_size == 0 || buffer_size > std::numeric_limits<uint32_t>::max())
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	auto const mmap_anonymous = [](size_t const size) -> result<unique_mmapping>
+	{
+		void* const addr = mmap(
+			nullptr,
+			size,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1,
+			0);
+
+		if (addr == MAP_FAILED)
+		{
+			return allio_ERROR(get_last_error_code());
+		}
+
+		return { result_value, reinterpret_cast<std::byte*>(addr), size };
+	};
+
+	auto group = std::make_unique<buffer_group>();
+	allio_TRYA(group->m_ring, mmap_anonymous(buffer_count * sizeof(io_uring_buf)));
+	allio_TRYA(group->m_buffers, mmap_anonymous(buffer_count * buffer_size));
+	group->m_buffer_count = buffer_count;
+	group->m_buffer_size = static_cast<uint32_t>(buffer_size);
+	group->m_tail = 0;
+
+	auto const sq_lock = lock(m_sq_mutex);
+
+	auto const it = std::find(m_buffer_groups.begin(), m_buffer_groups.end(), nullptr);
+
+	if (it == m_buffer_groups.end() && m_buffer_groups.size() > std::numeric_limits<uint16_t>::max())
+	{
+		return allio_ERROR(make_error_code(std::errc::too_many_files_open));
+	}
+
+	group->m_id = static_cast<uint16_t>(it - m_buffer_groups.begin());
+
+	io_uring_buf_reg const buf_reg =
+	{
+		.ring_addr = reinterpret_cast<uintptr_t>(group->m_ring.get()),
+		.ring_entries = buffer_count,
+		.bgid = group->m_id,
+	};
+
+	if (io_uring_register(m_io_uring, IORING_REGISTER_PBUF_RING, &buf_reg, 1) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	// Initially all buffers are provided to the kernel.
+	for (uint32_t i = 0; i < buffer_count; ++i)
+	{
+		release_provided_buffer(*group, static_cast<uint16_t>(i));
+	}
+
+	if (it == m_buffer_groups.end())
+	{
+		m_buffer_groups.push_back(std::move(group));
+		return m_buffer_groups.back()->m_id;
+	}
+
+	*it = std::move(group);
+	return (*it)->m_id;
+}
+
+result<void> io_uring_multiplexer::destroy_buffer_group(uint16_t const group)
+{
+	auto const sq_lock = lock(m_sq_mutex);
+
+	if (group >= m_buffer_groups.size() || m_buffer_groups[group] == nullptr)
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	io_uring_buf_reg const buf_reg =
+	{
+		.bgid = group,
+	};
+
+	if (io_uring_register(m_io_uring, IORING_UNREGISTER_PBUF_RING, &buf_reg, 1) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	m_buffer_groups[group].reset();
+	return {};
+}
+
+result<io_uring_multiplexer::buffer_group const*> io_uring_multiplexer::find_buffer_group(uint16_t const group)
+{
+	auto const sq_lock = lock(m_sq_mutex);
+
+	if (group >= m_buffer_groups.size() || m_buffer_groups[group] == nullptr)
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	return m_buffer_groups[group].get();
+}
+
+void io_uring_multiplexer::release_provided_buffer(provided_buffer const buffer)
+{
+	allio_ASSERT(buffer);
+
+	auto const sq_lock = lock(m_sq_mutex);
+
+	allio_ASSERT(buffer.group < m_buffer_groups.size());
+	release_provided_buffer(*m_buffer_groups[buffer.group], buffer.index);
+}
+
+void io_uring_multiplexer::release_provided_buffer(buffer_group& group, uint16_t const index)
+{
+	auto const ring = reinterpret_cast<io_uring_buf_ring*>(group.m_ring.get());
+
+	// The ring tail overlays the reserved field of the first entry, so it must not be overwritten.
+	io_uring_buf& buf = ring->bufs[group.m_tail & group.m_buffer_count - 1];
+	buf.addr = reinterpret_cast<uintptr_t>(group.m_buffers.get() + static_cast<size_t>(index) * group.m_buffer_size);
+	buf.len = group.m_buffer_size;
+	buf.bid = index;
+
+	std::atomic_ref(ring->tail).store(++group.m_tail, std::memory_order_release);
+}
+
+result<void> io_uring_multiplexer::push_internal(bool const submit, uint32_t const sqe_count, auto&& init_sqe)
+{
+	defer_context defer_context;
+
+	if (sqe_count > max_push_sqe_count)
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	if (m_lock_free_submission)
+	{
+		// Linked entries are reserved together, so they are adjacent in the submission ring.
+		allio_TRY(sq_position, reserve_sqes(defer_context, sqe_count));
+
+		for (uint32_t i = 0; i < sqe_count; ++i)
+		{
+			init_sqe(i, use_sqe(m_sq_k_array[sq_position + i & m_sq_size - 1]));
+		}
+
+		publish_sqes(sq_position, sqe_count);
+
+		if (submit || (m_flags & IORING_SETUP_SQPOLL) != 0)
+		{
+			allio_TRYV(flush_lock_free_submissions(defer_context));
+		}
+
+		return {};
+	}
+
+	auto const sq_lock = lock(m_sq_mutex);
+
+	uint32_t sqe_indices[max_push_sqe_count];
+
+	for (uint32_t i = 0; i < sqe_count; ++i)
+	{
+		auto const sqe_index = acquire_sqe(defer_context);
+
+		if (!sqe_index)
+		{
+			// Linked entries must be pushed together or not at all.
+			while (i-- > 0)
+			{
+				unacquire_sqe();
+			}
+
+			return allio_ERROR(sqe_index.error());
+		}
+
+		sqe_indices[i] = *sqe_index;
+	}
+
+	for (uint32_t i = 0; i < sqe_count; ++i)
+	{
+		init_sqe(i, use_sqe(sqe_indices[i]));
+	}
+
+	for (uint32_t i = 0; i < sqe_count; ++i)
+	{
+		release_sqe(sqe_indices[i]);
+	}
+
+	if (submit)
+	{
+		allio_TRYV(enter(defer_context, true, false, deadline::instant()));
+	}
+	else if ((m_flags & IORING_SETUP_SQPOLL) != 0)
+	{
+		flush_submission_queue(defer_context);
+	}
+
+	return {};
+}
+
+uint32_t io_uring_multiplexer::get_sqe_count(async_operation_storage const& storage)
+{
+	uint32_t sqe_count = 1;
+
+	if (storage.m_init_link_sqe != nullptr)
+	{
+		++sqe_count;
+	}
+
+	if (storage.m_deadline != deadline::never())
+	{
+		++sqe_count;
+	}
+
+	return sqe_count;
+}
+
+void io_uring_multiplexer::init_entry_sqe(async_operation_storage& storage, uint32_t index, io_uring_sqe& sqe, uint8_t const link_flags)
+{
+	if (storage.m_init_link_sqe != nullptr)
+	{
+		if (index == 0)
+		{
+			storage.m_init_link_sqe(storage, sqe);
+
+			allio_ASSERT(sqe.user_data == 0);
+			sqe.user_data = reinterpret_cast<uintptr_t>(&storage) | user_data_link;
+			sqe.flags |= IOSQE_IO_LINK;
+
+			return;
+		}
+
+		--index;
+	}
+
+	if (index == 0)
+	{
+		init_operation_sqe(storage, sqe, storage.m_deadline != deadline::never() ? IOSQE_IO_LINK : link_flags);
+	}
+	else
+	{
+		init_link_timeout_sqe(storage, sqe, link_flags);
+	}
+}
+
+void io_uring_multiplexer::init_operation_sqe(async_operation_storage& storage, io_uring_sqe& sqe, uint8_t const link_flags)
+{
+	storage.m_init_sqe(storage, sqe);
+
+	allio_ASSERT(sqe.user_data == 0);
+	sqe.user_data = reinterpret_cast<uintptr_t>(&storage);
+	sqe.flags |= link_flags;
+}
+
+void io_uring_multiplexer::init_link_timeout_sqe(async_operation_storage& storage, io_uring_sqe& sqe, uint8_t const link_flags)
+{
+	// The timeout cancels the preceding operation if it has not completed by the deadline.
+	sqe.opcode = IORING_OP_LINK_TIMEOUT;
+	sqe.addr = reinterpret_cast<uintptr_t>(&storage.m_link_timeout);
+	sqe.len = 1;
+	sqe.flags = link_flags;
+	sqe.user_data = user_data_timeout;
+
+	if (storage.m_deadline.is_absolute())
+	{
+		sqe.timeout_flags = IORING_TIMEOUT_ABS;
+	}
+}
+
+result<void> io_uring_multiplexer::push(async_operation_storage& storage, init_sqe_callback<>* const init_sqe)
+{
+	return push(storage, nullptr, init_sqe);
+}
+
+result<void> io_uring_multiplexer::push(async_operation_storage& storage, init_sqe_callback<>* const init_link_sqe, init_sqe_callback<>* const init_sqe)
+{
+	allio_ASSERT(!storage.is_scheduled());
+
+	storage.m_init_sqe = init_sqe;
+	storage.m_init_link_sqe = init_link_sqe;
+
+	if (storage.m_deadline != deadline::never())
+	{
+		// Linked timeouts cannot be polled for.
+		if (has_completion_polling())
+		{
+			return allio_ERROR(make_error_code(std::errc::not_supported));
+		}
+
+		if (storage.m_deadline.is_absolute())
+		{
+			storage.m_link_timeout = make_timespec(storage.m_deadline.absolute().time_since_epoch());
+		}
+		else
+		{
+			storage.m_link_timeout = make_timespec(storage.m_deadline.relative());
+		}
+	}
+
+	if (s_chain.multiplexer == this)
+	{
+		s_chain.operations.defer(&storage);
+		s_chain.sqe_count += get_sqe_count(storage);
+	}
+	else
+	{
+		allio_TRYV(push_internal(!m_defer_submission && !storage.m_defer_submission, get_sqe_count(storage), [&](uint32_t const index, io_uring_sqe& sqe)
+		{
+			init_entry_sqe(storage, index, sqe, 0);
+		}));
+	}
+
+	set_status(storage, async_operation_status::scheduled);
+
+	return {};
+}
+
+void io_uring_multiplexer::post_synchronous_completion(async_operation_storage& storage, int const result)
+{
+	set_result(storage, as_error_code(storage.set_result(result)));
+	set_status(storage,
+		async_operation_status::completed |
+		async_operation_status::concluded);
+
+	if (storage.get_listener() != nullptr)
+	{
+		++m_synchronous_completion_count;
+		m_synchronous_completion_list.defer(&storage);
+	}
+}
+
+result<void> io_uring_multiplexer::cancel(async_operation_storage& storage)
+{
+	if (has_completion_polling())
+	{
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+
+	storage.m_cancel_requested = true;
+
+	return push_internal(!m_defer_submission, 1, [&](uint32_t, io_uring_sqe& sqe)
+	{
+		sqe.opcode = IORING_OP_ASYNC_CANCEL;
+		sqe.addr = reinterpret_cast<uintptr_t>(&storage);
+		sqe.user_data = reinterpret_cast<uintptr_t>(&storage) | user_data_cancel;
+	});
+}
+
+result<void> io_uring_multiplexer::begin_chain(chain_mode const mode)
+{
+	if (s_chain.multiplexer != nullptr)
+	{
+		return allio_ERROR(make_error_code(std::errc::operation_in_progress));
+	}
+
+	s_chain.multiplexer = this;
+	s_chain.mode = mode;
+
+	return {};
+}
+
+result<void> io_uring_multiplexer::end_chain()
+{
+	allio_ASSERT(s_chain.multiplexer == this);
+
+	uint8_t const link_flag = s_chain.mode == chain_mode::hard_link
+		? IOSQE_IO_HARDLINK
+		: IOSQE_IO_LINK;
+
+	uint32_t const sqe_count = s_chain.sqe_count;
+	async_operation_storage* const head = s_chain.operations.m_head;
+
+	s_chain.multiplexer = nullptr;
+	s_chain.sqe_count = 0;
+	s_chain.operations.m_head = nullptr;
+	s_chain.operations.m_tail = nullptr;
+
+	if (head == nullptr)
+	{
+		return {};
+	}
+
+	async_operation_storage* storage = head;
+	uint32_t storage_sqe_index = 0;
+
+	auto const result = push_internal(!m_defer_submission, sqe_count, [&](uint32_t, io_uring_sqe& sqe)
+	{
+		uint8_t const next_link_flag = storage->m_next_chained != nullptr ? link_flag : 0;
+
+		init_entry_sqe(*storage, storage_sqe_index, sqe, next_link_flag);
+
+		if (++storage_sqe_index == get_sqe_count(*storage))
+		{
+			storage = storage->m_next_chained;
+			storage_sqe_index = 0;
+		}
+	});
+
+	if (!result)
+	{
+		// None of the operations were pushed, so they are concluded with the error.
+		for (storage = head; storage != nullptr;)
+		{
+			async_operation_storage* const next = storage->m_next_chained;
+
+			if (storage->m_capture_failure)
+			{
+				// Operations capturing their failures release their resources on completion.
+				(void)storage->set_result(-ECANCELED);
+			}
+
+			set_result(*storage, result.error());
+			set_status(*storage,
+				async_operation_status::completed |
+				async_operation_status::concluded);
+
+			if (storage->get_listener() != nullptr)
+			{
+				++m_synchronous_completion_count;
+				m_synchronous_completion_list.defer(storage);
+			}
+
+			storage = next;
+		}
+
+		return allio_ERROR(result.error());
+	}
+
+	return {};
+}
+
+result<uint32_t> io_uring_multiplexer::acquire_file_slot()
+{
+	auto const sq_lock = lock(m_sq_mutex);
+
+	if (m_file_table.size() == 0)
+	{
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+
+	return m_file_table.acquire();
+}
+
+void io_uring_multiplexer::release_file_slot(uint32_t const slot)
+{
+	// Slots allocated by the kernel are freed by clearing them.
+	if (slot < m_file_table.size())
+	{
+		auto const sq_lock = lock(m_sq_mutex);
+		m_file_table.release(slot);
+	}
+}
+
+result<void> io_uring_multiplexer::post_message(message_sender& sender, io_uring_multiplexer& target, message_receiver& receiver, uint32_t const value)
+{
+	sender.m_target = &target;
+	sender.m_receiver = &receiver;
+	sender.m_value = value;
+
+	return push(sender, +[](message_sender& sender, io_uring_sqe& sqe)
+	{
+		sqe.opcode = IORING_OP_MSG_RING;
+		sqe.fd = sender.m_target->m_io_uring;
+		sqe.addr = IORING_MSG_DATA;
+		sqe.len = sender.m_value;
+		sqe.off = reinterpret_cast<uintptr_t>(sender.m_receiver) | user_data_message;
+	});
+}
+
+result<void> io_uring_multiplexer::post_descriptor(message_sender& sender, io_uring_multiplexer& target, message_receiver& receiver, platform_handle const& handle)
+{
+	if (handle.get_multiplexer() != this || handle.get_multiplexer_data() == nullptr)
+	{
+		return allio_ERROR(make_error_code(std::errc::bad_file_descriptor));
+	}
+
+	if (!target.has_direct_file_allocation())
+	{
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+
+	sender.m_target = &target;
+	sender.m_receiver = &receiver;
+	sender.m_descriptor_slot = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(handle.get_multiplexer_data()) - 1);
+
+	return push(sender, +[](message_sender& sender, io_uring_sqe& sqe)
+	{
+		sqe.opcode = IORING_OP_MSG_RING;
+		sqe.fd = sender.m_target->m_io_uring;
+		sqe.addr = IORING_MSG_SEND_FD;
+		sqe.addr3 = sender.m_descriptor_slot;
+		sqe.file_index = IORING_FILE_INDEX_ALLOC;
+		sqe.off = reinterpret_cast<uintptr_t>(sender.m_receiver) | user_data_descriptor;
+	});
+}
+
+result<io_uring_multiplexer::splice_pipe> io_uring_multiplexer::acquire_splice_pipe()
+{
+	{
+		auto const sq_lock = lock(m_sq_mutex);
+
+		if (!m_splice_pipes.empty())
+		{
+			splice_pipe const pipe = m_splice_pipes.back();
+			m_splice_pipes.pop_back();
+			return pipe;
+		}
+	}
+
+	int fds[2];
+	if (pipe2(fds, O_CLOEXEC) == -1)
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	// A larger pipe allows larger transfers per operation. Failure leaves the default capacity.
+	(void)fcntl(fds[1], F_SETPIPE_SZ, 1024 * 1024);
+
+	int const capacity = fcntl(fds[1], F_GETPIPE_SZ);
+
+	if (capacity == -1)
+	{
+		std::error_code const error = get_last_error_code();
+		detail::fd_deleter::release(fds[0]);
+		detail::fd_deleter::release(fds[1]);
+		return allio_ERROR(error);
+	}
+
+	return splice_pipe{ fds[0], fds[1], static_cast<uint32_t>(capacity) };
+}
+
+void io_uring_multiplexer::release_splice_pipe(splice_pipe const pipe, bool const empty)
+{
+	if (empty)
+	{
+		auto const sq_lock = lock(m_sq_mutex);
+		m_splice_pipes.push_back(pipe);
+	}
+	else
+	{
+		detail::fd_deleter::release(pipe.read_fd);
+		detail::fd_deleter::release(pipe.write_fd);
+	}
+}
+
+std::unique_lock<std::mutex> io_uring_multiplexer::lock(std::optional<std::mutex>& mutex)
+{
+	if (mutex)
+	{
+		return std::unique_lock<std::mutex>(*mutex);
+	}
+	return std::unique_lock<std::mutex>();
+}
+
+io_uring_sqe& io_uring_multiplexer::use_sqe(uint32_t const sqe_index)
+{
+	io_uring_sqe& sqe = m_sqes[sqe_index];
+	memset(&sqe, 0, sizeof(sqe) << get_sqe_shift(m_flags));
+	return sqe;
+}
+
+result<uint32_t> io_uring_multiplexer::acquire_sqe()
+{
+	allio_TRYV(acquire_cqe());
+
+	auto const sq_k_consume = std::atomic_ref(*m_sq_k_consume);
+
+	uint32_t const sq_consume = sq_k_consume.load(std::memory_order_relaxed);
+	uint32_t const sq_acquire = m_sq_acquire;
+
+	if (sq_acquire == sq_consume)
+	{
+		unacquire_cqe();
+		return allio_ERROR(error::too_many_concurrent_async_operations);
+	}
+
+	m_sq_acquire = sq_acquire + 1;
+	return m_sq_k_array[sq_acquire & m_sq_size - 1];
+}
+
+result<uint32_t> io_uring_multiplexer::acquire_sqe(defer_context& defer_context)
+{
+	result<uint32_t> sqe_index = acquire_sqe();
+
+	if (!sqe_index && m_sq_submit != m_sq_release)
+	{
+		// The submission queue is full of deferred entries. Submit them to make room.
+		allio_TRYV(enter(defer_context, true, false, deadline::instant()));
+		sqe_index = acquire_sqe();
+	}
+
+	return sqe_index;
+}
+
+void io_uring_multiplexer::unacquire_sqe()
+{
+	--m_sq_acquire;
+	unacquire_cqe();
+}
+
+void io_uring_multiplexer::release_sqe(uint32_t const sqe_index)
+{
+	uint32_t const sq_release = m_sq_release++;
+	m_sq_k_array[sq_release & m_sq_size - 1] = sqe_index;
 }
 
 result<void> io_uring_multiplexer::acquire_cqe()
@@ -479,15 +1505,27 @@ result<void> io_uring_multiplexer::acquire_cqe()
 
 	if (sq_cq_available == 0)
 	{
-		uint32_t const cq_cq_available = m_cq_cq_available.load(std::memory_order_acquire);
-
-		if (cq_cq_available == 0)
+		if (m_cq_cq_available.load(std::memory_order_acquire) != 0)
 		{
-			return allio_ERROR(error::too_many_concurrent_async_operations);
+			sq_cq_available = m_cq_cq_available.exchange(0, std::memory_order_acq_rel);
+
+			// Released CQEs first repay those acquired beyond the size of the completion queue.
+			uint32_t const repaid = std::min(sq_cq_available, m_sq_cq_overcommit);
+			m_sq_cq_overcommit -= repaid;
+			sq_cq_available -= repaid;
 		}
 
-		sq_cq_available = m_cq_cq_available.exchange(0, std::memory_order_acq_rel);
-		allio_ASSERT(sq_cq_available >= cq_cq_available);
+		if (sq_cq_available == 0)
+		{
+			if ((m_features & IORING_FEAT_NODROP) == 0)
+			{
+				return allio_ERROR(error::too_many_concurrent_async_operations);
+			}
+
+			// The kernel holds completions which do not fit in the completion queue until they are drained.
+			++m_sq_cq_overcommit;
+			return {};
+		}
 	}
 
 	m_sq_cq_available = sq_cq_available - 1;
@@ -495,22 +1533,238 @@ result<void> io_uring_multiplexer::acquire_cqe()
 	return {};
 }
 
+void io_uring_multiplexer::unacquire_cqe()
+{
+	// Like released CQEs, an unused CQE first repays those acquired beyond the size of the completion queue.
+	if (m_sq_cq_overcommit != 0)
+	{
+		--m_sq_cq_overcommit;
+	}
+	else
+	{
+		++m_sq_cq_available;
+	}
+}
+
 void io_uring_multiplexer::release_cqe()
 {
 	(void)m_cq_cq_available.fetch_add(1, std::memory_order_acq_rel);
 }
 
-uint32_t io_uring_multiplexer::flush_submission_queue(defer_context& defer_context)
+io_uring_multiplexer::enter_timeout* io_uring_multiplexer::acquire_enter_timeout()
+{
+	if (m_sq_enter_timeout_free == nullptr)
+	{
+		m_sq_enter_timeout_free = m_cq_enter_timeout_free.exchange(nullptr, std::memory_order_acquire);
+	}
+
+	if (enter_timeout* const timeout = m_sq_enter_timeout_free)
+	{
+		m_sq_enter_timeout_free = timeout->next;
+		return timeout;
+	}
+
+	return m_enter_timeouts.emplace_back(std::make_unique<enter_timeout>()).get();
+}
+
+void io_uring_multiplexer::release_enter_timeout(enter_timeout* const timeout)
+{
+	timeout->next = m_cq_enter_timeout_free.load(std::memory_order_relaxed);
+	while (!m_cq_enter_timeout_free.compare_exchange_weak(timeout->next, timeout, std::memory_order_release, std::memory_order_relaxed));
+}
+
+result<uint32_t> io_uring_multiplexer::reserve_sqes(uint32_t const count)
+{
+	// CQEs are acquired from the counter shared with the completion thread.
+	// With NODROP the counter may go negative, in which case released CQEs first repay the overcommit.
+	int32_t const cq_available = static_cast<int32_t>(m_cq_cq_available.fetch_sub(count, std::memory_order_acq_rel));
+
+	if (cq_available < static_cast<int32_t>(count) && (m_features & IORING_FEAT_NODROP) == 0)
+	{
+		(void)m_cq_cq_available.fetch_add(count, std::memory_order_acq_rel);
+		return allio_ERROR(error::too_many_concurrent_async_operations);
+	}
+
+	auto const sq_acquire = std::atomic_ref(m_sq_acquire);
+	auto const sq_k_consume = std::atomic_ref(*m_sq_k_consume);
+
+	uint32_t acquire = sq_acquire.load(std::memory_order_relaxed);
+
+	do
+	{
+		if (sq_k_consume.load(std::memory_order_acquire) - acquire < count)
+		{
+			(void)m_cq_cq_available.fetch_add(count, std::memory_order_acq_rel);
+			return allio_ERROR(error::too_many_concurrent_async_operations);
+		}
+	}
+	while (!sq_acquire.compare_exchange_weak(acquire, acquire + count, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	return acquire + m_sq_size;
+}
+
+result<uint32_t> io_uring_multiplexer::reserve_sqes(defer_context& defer_context, uint32_t const count)
+{
+	result<uint32_t> sq_position = reserve_sqes(count);
+
+	if (!sq_position && sq_position.error() == error::too_many_concurrent_async_operations)
+	{
+		// The submission queue may be full of deferred entries. Submit them to make room.
+		allio_TRYV(flush_lock_free_submissions(defer_context));
+		sq_position = reserve_sqes(count);
+	}
+
+	return sq_position;
+}
+
+void io_uring_multiplexer::publish_sqes(uint32_t const position, uint32_t const count)
+{
+	auto const sq_release = std::atomic_ref(m_sq_release);
+
+	// Entries are published in the order they were reserved.
+	// Wait for the threads which reserved the preceding entries to publish them.
+	while (sq_release.load(std::memory_order_acquire) != position)
+	{
+		atomic_spin_hint();
+	}
+
+	sq_release.store(position + count, std::memory_order_seq_cst);
+}
+
+result<void> io_uring_multiplexer::flush_lock_free_submissions(defer_context& defer_context)
+{
+	auto const sq_release = std::atomic_ref(m_sq_release);
+
+	// Entries published while another thread is flushing are left to that thread,
+	// which checks for them after clearing the flag.
+	while (!m_sq_flushing.exchange(true, std::memory_order_seq_cst))
+	{
+		result<void> const r = enter(defer_context, true, false, deadline::instant());
+		uint32_t const sq_submit = m_sq_submit;
+
+		m_sq_flushing.store(false, std::memory_order_seq_cst);
+
+		if (!r)
+		{
+			return r;
+		}
+
+		if (sq_release.load(std::memory_order_seq_cst) == sq_submit)
+		{
+			break;
+		}
+	}
+
+	return {};
+}
+
+void io_uring_multiplexer::distribute_completions(defer_context& defer_context)
+{
+	if (m_completion_worker_count == 0)
+	{
+		return;
+	}
+
+	defer_context.completed_list.flush([&](async_operation_storage& storage)
+	{
+		uint32_t const worker_index = storage.m_completion_worker != async_operation_storage::any_completion_worker
+			? storage.m_completion_worker % m_completion_worker_count
+			: m_completion_worker_next++ % m_completion_worker_count;
+
+		auto& head = m_completion_workers[worker_index].m_head;
+
+		async_operation_storage* next = head.load(std::memory_order_relaxed);
+		do
+		{
+			storage.m_next_completed = next;
+		}
+		while (!head.compare_exchange_weak(next, &storage, std::memory_order_seq_cst, std::memory_order_relaxed));
+	});
+
+	for (uint32_t i = 0; i < m_completion_worker_count; ++i)
+	{
+		completion_worker& worker = m_completion_workers[i];
+
+		if (worker.m_waiting.load(std::memory_order_seq_cst) && worker.m_head.load(std::memory_order_relaxed) != nullptr)
+		{
+			std::lock_guard const lock(worker.m_mutex);
+			worker.m_condition.notify_one();
+		}
+	}
+}
+
+bool io_uring_multiplexer::run_completions(completion_worker& worker)
+{
+	async_operation_storage* storage = worker.m_head.exchange(nullptr, std::memory_order_acquire);
+
+	if (storage == nullptr)
+	{
+		return false;
+	}
+
+	// The stack holds the operations in reverse order of completion.
+	async_operation_storage* previous = nullptr;
+	while (storage != nullptr)
+	{
+		previous = std::exchange(storage, std::exchange(storage->m_next_completed, previous));
+	}
+
+	for (storage = previous; storage != nullptr;)
+	{
+		async_operation_storage& completed = *std::exchange(storage, storage->m_next_completed);
+
+		set_status(completed, async_operation_status::concluded);
+
+		auto const listener = completed.get_listener();
+		allio_ASSERT(listener != nullptr);
+		listener->completed(completed);
+		listener->concluded(completed);
+	}
+
+	return true;
+}
+
+void io_uring_multiplexer::notify_completion_workers()
 {
-	uint32_t const sq_release = m_sq_release;
+	(void)m_completion_reap_generation.fetch_add(1, std::memory_order_seq_cst);
+
+	for (uint32_t i = 0; i < m_completion_worker_count; ++i)
+	{
+		completion_worker& worker = m_completion_workers[i];
 
-	if ((m_flags & IORING_SETUP_SQPOLL) == 0)
+		if (worker.m_waiting.load(std::memory_order_seq_cst))
+		{
+			std::lock_guard const lock(worker.m_mutex);
+			worker.m_condition.notify_one();
+		}
+	}
+}
+
+bool io_uring_multiplexer::has_pending_task_work() const
+{
+	if ((m_flags & IORING_SETUP_TASKRUN_FLAG) == 0)
 	{
-		auto const sq_k_produce = std::atomic_ref(*m_sq_k_produce);
-		sq_k_produce.store(sq_release, std::memory_order_release);
+		return false;
 	}
 
-	//TODO: defer submitted
+	return (std::atomic_ref(*m_sq_k_flags).load(std::memory_order_acquire) & IORING_SQ_TASKRUN) != 0;
+}
+
+bool io_uring_multiplexer::has_completion_overflow() const
+{
+	return (std::atomic_ref(*m_sq_k_flags).load(std::memory_order_acquire) & IORING_SQ_CQ_OVERFLOW) != 0;
+}
+
+uint32_t io_uring_multiplexer::flush_submission_queue(defer_context& defer_context)
+{
+	uint32_t const sq_release = std::atomic_ref(m_sq_release).load(std::memory_order_acquire);
+
+	// Released entries are published together, so that the kernel never observes a partial chain.
+	auto const sq_k_produce = std::atomic_ref(*m_sq_k_produce);
+	sq_k_produce.store(sq_release, std::memory_order_release);
+
+	// Operations are not marked submitted, nor are their listeners notified. Once published, an operation may be
+	// completed and concluded by another thread before the submitting thread could do either.
 
 	return sq_release - std::exchange(m_sq_submit, sq_release);
 }
@@ -537,24 +1791,99 @@ uint32_t io_uring_multiplexer::flush_completion_queue(defer_context& defer_conte
 	uint32_t const cq_consume = cq_k_consume.load(std::memory_order_relaxed);
 	uint32_t const cq_produce = cq_k_produce.load(std::memory_order_acquire);
 
+	uint32_t new_cq_consume = cq_consume;
+
 	if (cq_consume != cq_produce)
 	{
-		for (uint32_t new_cq_consume = cq_consume; new_cq_consume != cq_produce; ++new_cq_consume)
+		for (; new_cq_consume != cq_produce; ++new_cq_consume)
 		{
 			io_uring_cqe const& cqe = m_cqes[(new_cq_consume & mask) << shift];
 			auto const storage = reinterpret_cast<async_operation_storage*>(cqe.user_data & user_data_ptr_mask);
+			uintptr_t const tag = cqe.user_data & user_data_tag_mask;
 
-			switch (cqe.user_data & user_data_tag_mask)
+			// The next completion of an operation with an undelivered intermediate result would overwrite it.
+			// The remaining completions are processed by the next flush, after the intermediate result is delivered.
+			if ((tag == user_data_normal || tag == user_data_message || tag == user_data_descriptor) &&
+				storage->m_yield_pending.load(std::memory_order_acquire))
+			{
+				break;
+			}
+
+			switch (tag)
 			{
 			case user_data_normal:
 				{
-					set_result(*storage, cqe.res >= 0
-						? as_error_code(storage->set_result(cqe.res))
-						: std::error_code(-cqe.res, std::system_category()));
+					storage->m_cqe_flags = cqe.flags;
+
+					bool cancelled;
+					if ((cqe.flags & IORING_CQE_F_NOTIF) != 0)
+					{
+						// The result was already set by the preceding completion.
+						cancelled = storage->get_result() == error::async_operation_cancelled;
+					}
+					else
+					{
+						// Operations cancelled by their linked timeout rather than by a cancellation request have timed out.
+						cancelled = cqe.res == -ECANCELED && storage->m_link_result >= 0 &&
+							(storage->m_cancel_requested || storage->m_deadline == deadline::never());
+
+						std::error_code result;
+						if (cqe.res >= 0)
+						{
+							result = as_error_code(storage->set_result(cqe.res));
+						}
+						else if (storage->m_capture_failure && storage->set_result(cqe.res))
+						{
+							// The operation recovered from the failure.
+							cancelled = false;
+						}
+						else if (cancelled)
+						{
+							result = error::async_operation_cancelled;
+						}
+						else if (storage->m_link_result < 0)
+						{
+							// The failure of the linked entry is reported as the failure of the operation.
+							result = std::error_code(-storage->m_link_result, std::system_category());
+						}
+						else if (cqe.res == -ECANCELED)
+						{
+							result = make_error_code(std::errc::timed_out);
+						}
+						else
+						{
+							result = std::error_code(-cqe.res, std::system_category());
+						}
+						set_result(*storage, result);
+					}
+
+					if ((cqe.flags & IORING_CQE_F_MORE) != 0)
+					{
+						if (storage->m_await_notification)
+						{
+							// The operation concludes when the kernel releases its buffers.
+							break;
+						}
+
+						// The operation remains armed. The intermediate result is delivered outside of the lock.
+						if (storage->get_listener() != nullptr)
+						{
+							storage->m_yield_pending.store(true, std::memory_order_relaxed);
+							defer_context.yielded_list.defer(storage);
+						}
+						break;
+					}
+
+					release_cqe();
 
 					async_operation_status new_status =
 						async_operation_status::completed;
 
+					if (cancelled)
+					{
+						new_status |= async_operation_status::cancelled;
+					}
+
 					if (storage->get_listener() != nullptr)
 					{
 						defer_context.completed_list.defer(storage);
@@ -569,33 +1898,47 @@ uint32_t io_uring_multiplexer::flush_completion_queue(defer_context& defer_conte
 				break;
 
 			case user_data_cancel:
-				if (cqe.res == 0)
-				{
-					set_result(*storage, error::async_operation_cancelled);
+				// The cancelled operation is concluded by its own completion.
+				release_cqe();
+				break;
 
-					async_operation_status new_status =
-						async_operation_status::completed |
-						async_operation_status::cancelled;
+			case user_data_timeout:
+				release_cqe();
+				break;
 
-					if (storage->get_listener() != nullptr)
-					{
-						defer_context.completed_list.defer(storage);
-					}
-					else
+			case user_data_enter_timeout:
+				release_enter_timeout(reinterpret_cast<enter_timeout*>(cqe.user_data & user_data_ptr_mask));
+				release_cqe();
+				break;
+
+			case user_data_link:
+				// Linked entries complete before their operation.
+				storage->m_link_result = cqe.res;
+				release_cqe();
+				break;
+
+			case user_data_message:
+			case user_data_descriptor:
+				{
+					// Messages are posted by other multiplexers and carry no completion queue credit.
+					auto const receiver = static_cast<message_receiver*>(storage);
+					receiver->m_value = static_cast<uint32_t>(cqe.res);
+					receiver->m_is_descriptor = tag == user_data_descriptor;
+
+					if (receiver->get_listener() != nullptr)
 					{
-						new_status |= async_operation_status::concluded;
+						receiver->m_yield_pending.store(true, std::memory_order_relaxed);
+						defer_context.yielded_list.defer(receiver);
 					}
-
-					set_status(*storage, new_status);
 				}
 				break;
 			}
 		}
 
-		cq_k_consume.store(cq_produce, std::memory_order_release);
+		cq_k_consume.store(new_cq_consume, std::memory_order_release);
 	}
 
-	return synchronous_completion_count + (cq_produce - cq_consume);
+	return synchronous_completion_count + (new_cq_consume - cq_consume);
 }
 
 result<void> io_uring_multiplexer::enter(defer_context& defer_context, bool const submission, bool const completion, deadline const deadline)
@@ -639,32 +1982,74 @@ result<void> io_uring_multiplexer::enter(defer_context& defer_context, bool cons
 			enter_completion_count = 1;
 			enter_flags |= IORING_ENTER_GETEVENTS;
 		}
+		else if (has_pending_task_work() || has_completion_overflow())
+		{
+			// Run the pending task work and drain overflowed completions without waiting.
+			need_enter = true;
+			enter_flags |= IORING_ENTER_GETEVENTS;
+		}
 	}
 
 	if (need_enter)
 	{
 		io_uring_getevents_arg enter_arg = {};
-		timespec64 enter_timespec;
+		__kernel_timespec enter_timespec;
+
+		void const* enter_arg_ptr = nullptr;
+		size_t enter_arg_size = 0;
 
-		if (deadline != deadline::never())
+		// Polled completions cannot be waited for with a timeout.
+		// Instead the completion queue is polled without waiting until the deadline.
+		bool poll_until_deadline = false;
+
+		if (deadline == deadline::instant())
 		{
-			if (deadline == deadline::instant())
-			{
-				enter_completion_count = 0;
-			}
-			else if ((m_features & IORING_FEAT_EXT_ARG) != 0)
+			enter_completion_count = 0;
+		}
+		else if (enter_completion_count != 0 && deadline != deadline::never() && has_completion_polling())
+		{
+			enter_completion_count = 0;
+			poll_until_deadline = true;
+		}
+		else if (enter_completion_count != 0 && deadline != deadline::never())
+		{
+			if ((m_features & IORING_FEAT_EXT_ARG) != 0)
 			{
-				//TODO: finish deadline support
-				return allio_ERROR(make_error_code(std::errc::not_supported));
-
-				//TODO: fill enter_timespec
+				// The EXT_ARG timeout is always relative.
+				enter_timespec = make_timespec(deadline.remaining());
 
 				enter_flags |= IORING_ENTER_EXT_ARG;
 				enter_arg.ts = reinterpret_cast<uintptr_t>(&enter_timespec);
+				enter_arg_ptr = &enter_arg;
+				enter_arg_size = sizeof(enter_arg);
 			}
 			else
 			{
-				return allio_ERROR(make_error_code(std::errc::not_supported));
+				// Older kernels require a timeout operation to end the wait.
+				// The timeout also completes on the first other completion.
+				allio_TRY(sqe_index, acquire_sqe());
+				enter_timeout* const timeout = acquire_enter_timeout();
+
+				io_uring_sqe& sqe = use_sqe(sqe_index);
+				sqe.opcode = IORING_OP_TIMEOUT;
+				sqe.addr = reinterpret_cast<uintptr_t>(&timeout->timespec);
+				sqe.len = 1;
+				sqe.off = 1;
+				sqe.user_data = reinterpret_cast<uintptr_t>(timeout) | user_data_enter_timeout;
+
+				if (deadline.is_absolute())
+				{
+					// Absolute timeouts are measured on CLOCK_MONOTONIC, same as the deadline clock.
+					timeout->timespec = make_timespec(deadline.absolute().time_since_epoch());
+					sqe.timeout_flags = IORING_TIMEOUT_ABS;
+				}
+				else
+				{
+					timeout->timespec = make_timespec(deadline.relative());
+				}
+
+				release_sqe(sqe_index);
+				enter_submission_count += flush_submission_queue(defer_context);
 			}
 		}
 
@@ -673,27 +2058,68 @@ result<void> io_uring_multiplexer::enter(defer_context& defer_context, bool cons
 			enter_submission_count,
 			enter_completion_count,
 			enter_flags,
-			nullptr, 0);
-			//&enter_arg,
-			//sizeof(enter_arg));
-			//TODO: fix arg
+			enter_arg_ptr,
+			enter_arg_size);
 
-		if (enter_result == -1)
+		if (enter_result == -1 && errno != ETIME && errno != EINTR)
 		{
 			return allio_ERROR(get_last_error_code());
 		}
 
-		if (submission)
-		{
-		}
-
 		if (completion)
 		{
-			flush_completion_queue(defer_context);
+			uint32_t completion_count = flush_completion_queue(defer_context);
+
+			if (poll_until_deadline)
+			{
+				auto const end = deadline.is_absolute()
+					? deadline.absolute()
+					: deadline::clock::now() + std::chrono::duration_cast<deadline::clock::duration>(deadline.relative());
+
+				while (completion_count == 0 && deadline::clock::now() < end)
+				{
+					if (io_uring_enter(m_io_uring, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0) == -1 && errno != EINTR)
+					{
+						return allio_ERROR(get_last_error_code());
+					}
+
+					completion_count = flush_completion_queue(defer_context);
+				}
+			}
 		}
 	}
 
 	return {};
 }
 
+
+result<io_uring_polling_group> io_uring_polling_group::create(io_uring_multiplexer::init_options const& options)
+{
+	if (options.share_kernel_polling_thread != nullptr)
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	io_uring_multiplexer::init_options primary_options = options;
+	primary_options.enable_kernel_polling_thread = true;
+
+	allio_TRY(init_result, io_uring_multiplexer::init(primary_options));
+	return io_uring_polling_group(std::make_unique<io_uring_multiplexer>(std::move(init_result)));
+}
+
+result<std::unique_ptr<io_uring_multiplexer>> io_uring_polling_group::attach(io_uring_multiplexer::init_options const& options) const
+{
+	if (options.share_kernel_polling_thread != nullptr && options.share_kernel_polling_thread != m_primary.get())
+	{
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	io_uring_multiplexer::init_options attached_options = options;
+	attached_options.enable_kernel_polling_thread = true;
+	attached_options.share_kernel_polling_thread = m_primary.get();
+
+	allio_TRY(init_result, io_uring_multiplexer::init(attached_options));
+	return std::make_unique<io_uring_multiplexer>(std::move(init_result));
+}
+
 allio_TYPE_ID(io_uring_multiplexer);
\ No newline at end of file
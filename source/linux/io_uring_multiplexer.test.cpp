@@ -0,0 +1,659 @@
+#include <allio/linux/io_uring_multiplexer.hpp>
+
+#include <allio/file_handle_async.hpp>
+#include <allio/socket_handle_async.hpp>
+#include <allio/sync_wait.hpp>
+
+#include <unifex/sender_concepts.hpp>
+#include <unifex/task.hpp>
+#include <unifex/when_all.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstring>
+
+using namespace allio;
+using namespace allio::linux;
+
+namespace {
+
+struct test_completion
+{
+	std::atomic<bool> done = false;
+	bool cancelled = false;
+	size_t value = 0;
+	std::error_code error;
+	std::exception_ptr exception;
+
+	// Thread on which the receiver was completed.
+	std::thread::id thread;
+};
+
+// Receiver recording the completion of a sender started outside of a coroutine.
+class test_receiver
+{
+	test_completion* m_completion;
+
+public:
+	explicit test_receiver(test_completion& completion)
+		: m_completion(&completion)
+	{
+	}
+
+	void set_value() && noexcept
+	{
+		complete();
+	}
+
+	void set_value(size_t const value) && noexcept
+	{
+		m_completion->value = value;
+		complete();
+	}
+
+	void set_error(std::error_code const error) && noexcept
+	{
+		m_completion->error = error;
+		complete();
+	}
+
+	void set_error(std::exception_ptr&& exception) && noexcept
+	{
+		m_completion->exception = static_cast<std::exception_ptr&&>(exception);
+		complete();
+	}
+
+	void set_done() && noexcept
+	{
+		m_completion->cancelled = true;
+		complete();
+	}
+
+private:
+	void complete()
+	{
+		m_completion->thread = std::this_thread::get_id();
+		m_completion->done.store(true, std::memory_order_release);
+	}
+};
+
+} // namespace
+
+static path get_temp_file_path(std::string_view const filename)
+{
+	return path((std::filesystem::temp_directory_path() / filename).string());
+}
+
+static std::unique_ptr<io_uring_multiplexer> create_multiplexer(io_uring_multiplexer::init_options const& options = {})
+{
+	auto init_result = io_uring_multiplexer::init(options);
+	if (!init_result)
+	{
+		SKIP("io_uring is not available with the requested options");
+	}
+	return std::make_unique<io_uring_multiplexer>(std::move(*init_result));
+}
+
+static file_handle open_file(io_uring_multiplexer& multiplexer, path const& path, file_parameters const& args = { .mode = file_mode::write, .creation = file_creation::truncate_existing })
+{
+	file_handle file;
+	file.set_multiplexer(&multiplexer).value();
+	file.open(path, args).value();
+	return file;
+}
+
+static void check_file_content(file_handle& file, std::string_view const content)
+{
+	std::string buffer(content.size(), '\0');
+	REQUIRE(file.read_at(0, as_read_buffer(buffer.data(), buffer.size())).value() == content.size());
+	REQUIRE(buffer == content);
+}
+
+// Connect a pair of sockets through the listening address.
+static void connect_sockets(io_uring_multiplexer& multiplexer, network_address const& address, socket_handle& server, socket_handle& client)
+{
+	sync_wait(multiplexer, [&]() -> unifex::task<void>
+	{
+		listen_socket_handle listen_socket = co_await listen_async(multiplexer, address);
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				server = (co_await listen_socket.accept_async()).socket;
+				server.set_multiplexer(&multiplexer);
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				client = co_await connect_async(multiplexer, address);
+			}()
+		);
+	}()).value();
+}
+
+// Start the sender without waiting for it. The operation must outlive its completion.
+template<typename Sender>
+static auto start_operation(Sender&& sender, test_completion& completion)
+{
+	using operation_type = unifex::connect_result_t<Sender, test_receiver>;
+	std::unique_ptr<operation_type> operation(new operation_type(unifex::connect(static_cast<Sender&&>(sender), test_receiver(completion))));
+	unifex::start(*operation);
+	return operation;
+}
+
+static void wait(io_uring_multiplexer& multiplexer, test_completion const& completion)
+{
+	while (!completion.done)
+	{
+		multiplexer.submit_and_poll().value();
+	}
+}
+
+TEST_CASE("io_uring_multiplexer deferred submission", "[io_uring_multiplexer]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	SECTION("Deferred operation")
+	{
+		auto const multiplexer = create_multiplexer();
+		file_handle file = open_file(*multiplexer, file_path);
+
+		test_completion completion;
+		auto const operation = start_operation(file.write_at_async(0, as_write_buffer("allio", 5)).defer_submission(), completion);
+
+		// Polling alone does not submit the operation.
+		multiplexer->poll(deadline::instant()).value();
+		REQUIRE(!completion.done);
+
+		while (!completion.done)
+		{
+			multiplexer->submit_and_poll().value();
+		}
+
+		REQUIRE(completion.value == 5);
+		check_file_content(file, "allio");
+	}
+
+	SECTION("Deferring multiplexer")
+	{
+		// The submission queue fills up before the explicit submission, and is then submitted automatically.
+		auto const multiplexer = create_multiplexer({ .min_submission_queue_size = 4, .defer_submission = true });
+		file_handle file = open_file(*multiplexer, file_path);
+
+		char const data[] = "012345";
+
+		test_completion completions[6];
+		std::vector<std::shared_ptr<void>> operations;
+
+		for (size_t i = 0; i < 6; ++i)
+		{
+			operations.push_back(start_operation(file.write_at_async(i, as_write_buffer(data + i, 1)), completions[i]));
+		}
+
+		for (test_completion const& completion : completions)
+		{
+			while (!completion.done)
+			{
+				multiplexer->submit_and_poll().value();
+			}
+
+			REQUIRE(completion.value == 1);
+		}
+
+		check_file_content(file, "012345");
+	}
+}
+
+TEST_CASE("io_uring_multiplexer poll deadline", "[io_uring_multiplexer]")
+{
+	using namespace std::chrono_literals;
+
+	auto const multiplexer = create_multiplexer();
+
+	bool const absolute = GENERATE(false, true);
+	CAPTURE(absolute);
+
+	// Without pending operations each wait ends at its deadline.
+	// Repeated waits reuse the timeout entries of older kernels.
+	for (int i = 0; i < 3; ++i)
+	{
+		auto const start = deadline::clock::now();
+		multiplexer->poll(absolute ? deadline(start + 20ms) : deadline(20ms)).value();
+		REQUIRE(deadline::clock::now() - start >= 20ms);
+	}
+
+	multiplexer->poll(deadline::instant()).value();
+}
+
+TEST_CASE("io_uring_multiplexer operation deadline", "[io_uring_multiplexer]")
+{
+	using namespace std::chrono_literals;
+
+	auto const multiplexer = create_multiplexer();
+
+	socket_handle server;
+	socket_handle client;
+	connect_sockets(*multiplexer, ipv4_address::localhost(51240), server, client);
+
+	// Nothing is written to the socket, so the read times out.
+	int data = 0;
+	for (bool const absolute : { false, true })
+	{
+		CAPTURE(absolute);
+
+		test_completion completion;
+		auto const start = deadline::clock::now();
+		auto const operation = start_operation(client.read_async(as_read_buffer(&data, 1))
+			.with_deadline(absolute ? deadline(start + 20ms) : deadline(20ms)), completion);
+
+		wait(*multiplexer, completion);
+		REQUIRE(completion.error == std::errc::timed_out);
+		REQUIRE(!completion.cancelled);
+		REQUIRE(deadline::clock::now() - start >= 20ms);
+	}
+
+	// Operations completing before their deadline are unaffected.
+	{
+		test_completion read_completion;
+		auto const read_operation = start_operation(client.read_async(as_read_buffer(&data, 1)).with_deadline(10s), read_completion);
+
+		int const reply_data = 42;
+		test_completion write_completion;
+		auto const write_operation = start_operation(server.write_async(as_write_buffer(&reply_data, 1)).with_deadline(10s), write_completion);
+
+		wait(*multiplexer, write_completion);
+		REQUIRE(!write_completion.error);
+		REQUIRE(write_completion.value == sizeof(reply_data));
+
+		wait(*multiplexer, read_completion);
+		REQUIRE(!read_completion.error);
+		REQUIRE(read_completion.value == sizeof(data));
+		REQUIRE(data == reply_data);
+	}
+}
+
+TEST_CASE("io_uring_multiplexer chain with a failing head", "[io_uring_multiplexer]")
+{
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	auto const multiplexer = create_multiplexer();
+
+	chain_mode const mode = GENERATE(chain_mode::link, chain_mode::hard_link);
+	CAPTURE(mode);
+
+	REQUIRE(open_file(*multiplexer, file_path).write_at(0, as_write_buffer("allio", 5)).value() == 5);
+
+	// Writing to a file opened for reading fails.
+	file_handle file = open_file(*multiplexer, file_path, { .mode = file_mode::read });
+
+	char buffer[] = "trash";
+	test_completion write_completion;
+	test_completion read_completion;
+
+	multiplexer->begin_chain(mode).value();
+	auto const write_operation = start_operation(file.write_at_async(0, as_write_buffer("trash", 5)), write_completion);
+	auto const read_operation = start_operation(file.read_at_async(0, as_read_buffer(buffer, 5)), read_completion);
+	multiplexer->end_chain().value();
+
+	wait(*multiplexer, write_completion);
+	wait(*multiplexer, read_completion);
+
+	REQUIRE(write_completion.error == std::errc::bad_file_descriptor);
+
+	if (mode == chain_mode::link)
+	{
+		// The failure cancels the rest of the chain.
+		REQUIRE(read_completion.cancelled);
+		REQUIRE(memcmp(buffer, "trash", 5) == 0);
+	}
+	else
+	{
+		// A hard link performs the rest of the chain regardless.
+		REQUIRE(!read_completion.error);
+		REQUIRE(read_completion.value == 5);
+		REQUIRE(memcmp(buffer, "allio", 5) == 0);
+	}
+}
+
+TEST_CASE("io_uring_multiplexer message ring", "[io_uring_multiplexer]")
+{
+	auto const source = create_multiplexer();
+	auto const target = create_multiplexer();
+
+	if (!source->supports_opcode(IORING_OP_MSG_RING))
+	{
+		SKIP("IORING_OP_MSG_RING is not supported");
+	}
+
+	struct message_listener : async_operation_listener
+	{
+		std::vector<uint32_t> values;
+
+		void yielded(async_operation& operation) override
+		{
+			auto const& receiver = static_cast<io_uring_multiplexer::message_receiver&>(operation);
+			REQUIRE(!receiver.is_descriptor());
+			values.push_back(receiver.get_value());
+		}
+	};
+
+	message_listener listener;
+	io_uring_multiplexer::message_receiver receiver(listener);
+
+	io_uring_multiplexer::message_sender sender_1;
+	io_uring_multiplexer::message_sender sender_2;
+	source->post_message(sender_1, *target, receiver, 42).value();
+	source->post_message(sender_2, *target, receiver, 43).value();
+
+	// The senders complete on the source once the messages have been delivered.
+	while (!sender_1.is_concluded() || !sender_2.is_concluded())
+	{
+		source->submit_and_poll().value();
+	}
+	REQUIRE(!sender_1.get_result());
+	REQUIRE(!sender_2.get_result());
+
+	// Each message is yielded to the listener of the receiver on the target.
+	while (listener.values.size() < 2)
+	{
+		target->poll().value();
+	}
+	REQUIRE(listener.values == std::vector<uint32_t>{ 42, 43 });
+}
+
+TEST_CASE("io_uring_multiplexer lock-free submission", "[io_uring_multiplexer]")
+{
+	using namespace std::chrono_literals;
+
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	// The submission queue is smaller than the number of operations, so that it fills up while threads are submitting.
+	auto const multiplexer = create_multiplexer({ .min_submission_queue_size = 16, .min_completion_queue_size = 32,
+		.enable_concurrent_completion = true, .enable_lock_free_submission = true });
+
+	file_handle file = open_file(*multiplexer, file_path);
+
+	constexpr size_t thread_count = 4;
+	constexpr size_t operation_count = 8;
+
+	char const data[] = "abcd";
+	test_completion completions[thread_count][operation_count];
+	std::vector<std::shared_ptr<void>> operations[thread_count];
+	{
+		std::vector<std::jthread> threads;
+		for (size_t t = 0; t < thread_count; ++t)
+		{
+			threads.emplace_back([&, t]()
+			{
+				for (size_t i = 0; i < operation_count; ++i)
+				{
+					operations[t].push_back(start_operation(file.write_at_async(t * operation_count + i, as_write_buffer(data + t, 1)), completions[t][i]));
+				}
+			});
+		}
+
+		// Completions are reaped while the other threads are submitting.
+		for (auto const& thread_completions : completions)
+		{
+			for (test_completion const& completion : thread_completions)
+			{
+				while (!completion.done)
+				{
+					multiplexer->poll(10ms).value();
+				}
+			}
+		}
+	}
+
+	for (auto const& thread_completions : completions)
+	{
+		for (test_completion const& completion : thread_completions)
+		{
+			REQUIRE(!completion.error);
+			REQUIRE(completion.value == 1);
+		}
+	}
+
+	check_file_content(file, "aaaaaaaabbbbbbbbccccccccdddddddd");
+}
+
+TEST_CASE("io_uring_multiplexer completion workers", "[io_uring_multiplexer]")
+{
+	using namespace std::chrono_literals;
+
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	constexpr uint32_t worker_count = 2;
+	constexpr size_t operation_count = 8;
+
+	auto const multiplexer = create_multiplexer({ .enable_concurrent_completion = true, .completion_worker_count = worker_count });
+
+	REQUIRE(multiplexer->poll_completion_worker(worker_count, deadline::instant()).error() == std::errc::invalid_argument);
+
+	file_handle file = open_file(*multiplexer, file_path);
+
+	char const data[] = "01234567";
+	test_completion completions[operation_count];
+	std::vector<std::shared_ptr<void>> operations;
+
+	for (size_t i = 0; i < operation_count; ++i)
+	{
+		operations.push_back(start_operation(file.write_at_async(i, as_write_buffer(data + i, 1)), completions[i]));
+	}
+
+	auto const all_done = [&]()
+	{
+		return std::ranges::all_of(completions, [](test_completion const& completion) { return completion.done.load(); });
+	};
+
+	// Each worker reaps the completion queue on behalf of both, or waits for the other to hand it completions.
+	std::thread::id worker_threads[worker_count];
+	std::error_code worker_errors[worker_count];
+	{
+		std::vector<std::jthread> threads;
+		for (uint32_t w = 0; w < worker_count; ++w)
+		{
+			threads.emplace_back([&, w]()
+			{
+				worker_threads[w] = std::this_thread::get_id();
+
+				while (!all_done())
+				{
+					if (auto const r = multiplexer->poll_completion_worker(w, 10ms); !r)
+					{
+						worker_errors[w] = r.error();
+						break;
+					}
+				}
+			});
+		}
+	}
+
+	for (std::error_code const error : worker_errors)
+	{
+		REQUIRE(!error);
+	}
+
+	// Operations without affinity are distributed evenly, and their receivers are completed by the workers.
+	size_t worker_completion_counts[worker_count] = {};
+	for (test_completion const& completion : completions)
+	{
+		REQUIRE(completion.done);
+		REQUIRE(completion.value == 1);
+
+		auto const worker = std::ranges::find(worker_threads, completion.thread);
+		REQUIRE(worker != std::ranges::end(worker_threads));
+		++worker_completion_counts[worker - worker_threads];
+	}
+
+	for (size_t const count : worker_completion_counts)
+	{
+		REQUIRE(count == operation_count / worker_count);
+	}
+
+	check_file_content(file, "01234567");
+}
+
+TEST_CASE("io_uring_multiplexer completion queue overcommit", "[io_uring_multiplexer]")
+{
+	using namespace std::chrono_literals;
+
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	// The completion queue holds 64 entries, far fewer than the number of operations in flight.
+	auto const multiplexer = create_multiplexer({ .min_submission_queue_size = 32, .min_completion_queue_size = 64, .defer_submission = true });
+
+	file_handle file = open_file(*multiplexer, file_path);
+
+	constexpr size_t operation_count = 256;
+
+	std::string data(operation_count, '\0');
+	for (size_t i = 0; i < operation_count; ++i)
+	{
+		data[i] = static_cast<char>('a' + i % 26);
+	}
+
+	std::vector<test_completion> completions(operation_count);
+	std::vector<std::shared_ptr<void>> operations;
+
+	// The full submission queue is submitted automatically, so the kernel completes operations before any are reaped.
+	for (size_t i = 0; i < operation_count; ++i)
+	{
+		operations.push_back(start_operation(file.write_at_async(i, as_write_buffer(data.data() + i, 1)), completions[i]));
+
+		if (completions[i].error == make_error_code(allio::error::too_many_concurrent_async_operations))
+		{
+			SKIP("The kernel does not support IORING_FEAT_NODROP");
+		}
+	}
+
+	// Completions which did not fit in the completion queue are held by the kernel until drained.
+	multiplexer->submit().value();
+	std::this_thread::sleep_for(10ms);
+
+	for (test_completion const& completion : completions)
+	{
+		wait(*multiplexer, completion);
+		REQUIRE(!completion.error);
+		REQUIRE(completion.value == 1);
+	}
+
+	check_file_content(file, data);
+}
+
+TEST_CASE("io_uring_multiplexer single issuer", "[io_uring_multiplexer]")
+{
+	// A single issuer ring cannot be used concurrently.
+	REQUIRE(io_uring_multiplexer::init({ .enable_concurrent_submission = true, .enable_single_issuer = true }).error() == std::errc::invalid_argument);
+	REQUIRE(io_uring_multiplexer::init({ .enable_concurrent_completion = true, .enable_single_issuer = true }).error() == std::errc::invalid_argument);
+	REQUIRE(io_uring_multiplexer::init({ .enable_lock_free_submission = true, .enable_single_issuer = true }).error() == std::errc::invalid_argument);
+
+	// Deferred task running requires a single issuer, and the task running flag requires cooperative or deferred task running.
+	REQUIRE(io_uring_multiplexer::init({ .enable_deferred_task_running = true }).error() == std::errc::invalid_argument);
+	REQUIRE(io_uring_multiplexer::init({ .enable_task_running_flag = true }).error() == std::errc::invalid_argument);
+
+	path const file_path = get_temp_file_path("allio-test-file");
+
+	auto const multiplexer = create_multiplexer({ .enable_single_issuer = true, .enable_deferred_task_running = true, .enable_task_running_flag = true });
+
+	file_handle file = open_file(*multiplexer, file_path);
+
+	test_completion write_completion;
+	auto const write_operation = start_operation(file.write_at_async(0, as_write_buffer("allio", 5)), write_completion);
+
+	wait(*multiplexer, write_completion);
+	REQUIRE(!write_completion.error);
+	REQUIRE(write_completion.value == 5);
+	check_file_content(file, "allio");
+
+	// The read completes by deferred task work, which runs only when the issuer enters the kernel.
+	socket_handle server;
+	socket_handle client;
+	connect_sockets(*multiplexer, ipv4_address::localhost(51246), server, client);
+
+	int data = 0;
+	test_completion read_completion;
+	auto const read_operation = start_operation(client.read_async(as_read_buffer(&data, 1)), read_completion);
+
+	int const reply_data = 42;
+	test_completion write_reply_completion;
+	auto const write_reply_operation = start_operation(server.write_async(as_write_buffer(&reply_data, 1)), write_reply_completion);
+
+	wait(*multiplexer, write_reply_completion);
+	REQUIRE(write_reply_completion.value == sizeof(reply_data));
+
+	wait(*multiplexer, read_completion);
+	REQUIRE(!read_completion.error);
+	REQUIRE(read_completion.value == sizeof(data));
+	REQUIRE(data == reply_data);
+}
+
+TEST_CASE("io_uring_multiplexer polling group", "[io_uring_multiplexer]")
+{
+	using namespace std::chrono_literals;
+
+	// Kernel polling thread options are invalid without the kernel polling thread.
+	REQUIRE(io_uring_multiplexer::init({ .kernel_polling_thread_cpu = 0u }).error() == std::errc::invalid_argument);
+	REQUIRE(io_uring_multiplexer::init({ .kernel_polling_thread_idle_time = 10ms }).error() == std::errc::invalid_argument);
+	REQUIRE(io_uring_multiplexer::init({ .enable_kernel_polling_thread = true, .kernel_polling_thread_idle_time = -1ms }).error() == std::errc::argument_out_of_domain);
+
+	auto const unrelated = create_multiplexer();
+
+	// The primary multiplexer of a group cannot itself be attached to another polling thread.
+	REQUIRE(io_uring_polling_group::create({ .share_kernel_polling_thread = unrelated.get() }).error() == std::errc::invalid_argument);
+
+	auto group = io_uring_polling_group::create({});
+	if (!group)
+	{
+		// Older kernels only permit the kernel polling thread to privileged processes.
+		SKIP("The kernel polling thread is not permitted");
+	}
+
+	// The polling thread options are taken from the primary multiplexer.
+	REQUIRE(group->attach({ .share_kernel_polling_thread = unrelated.get() }).error() == std::errc::invalid_argument);
+	REQUIRE(group->attach({ .kernel_polling_thread_cpu = 0u }).error() == std::errc::invalid_argument);
+	REQUIRE(group->attach({ .kernel_polling_thread_idle_time = 10ms }).error() == std::errc::invalid_argument);
+
+	std::unique_ptr<io_uring_multiplexer> const attached = group->attach({ .share_kernel_polling_thread = &group->get_primary() }).value();
+
+	path const file_paths[] =
+	{
+		get_temp_file_path("allio-test-file"),
+		get_temp_file_path("allio-test-file-2"),
+	};
+
+	// Both multiplexers submit through the same kernel polling thread.
+	io_uring_multiplexer* const multiplexers[] = { &group->get_primary(), attached.get() };
+
+	file_handle files[] =
+	{
+		open_file(*multiplexers[0], file_paths[0]),
+		open_file(*multiplexers[1], file_paths[1]),
+	};
+
+	test_completion completions[2];
+	std::vector<std::shared_ptr<void>> operations;
+
+	operations.push_back(start_operation(files[0].write_at_async(0, as_write_buffer("allio", 5)), completions[0]));
+	operations.push_back(start_operation(files[1].write_at_async(0, as_write_buffer("oilla", 5)), completions[1]));
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		wait(*multiplexers[i], completions[i]);
+		REQUIRE(!completions[i].error);
+		REQUIRE(completions[i].value == 5);
+	}
+
+	check_file_content(files[0], "allio");
+	check_file_content(files[1], "oilla");
+}
@@ -8,6 +8,40 @@
 #include <allio/linux/detail/undef.i>
 
 namespace allio {
+namespace linux {
+
+// Attach a direct descriptor allocated by the kernel to a handle, binding the handle to the multiplexer.
+// The slot is cleared if the handle cannot take ownership of it.
+template<std::derived_from<platform_handle> Handle>
+result<void> consume_direct_handle(io_uring_multiplexer& m, Handle& managed_handle, handle::native_handle_type const handle_handle, uint32_t const slot, auto&&... args)
+{
+	native_platform_handle const handle = wrap_direct_handle(slot);
+
+	result<void> r = managed_handle.set_multiplexer(&m);
+
+	if (r)
+	{
+		r = managed_handle.set_native_handle(
+		{
+			platform_handle::native_handle_type
+			{
+				handle_handle,
+				handle,
+			},
+			static_cast<decltype(args)&&>(args)...
+		});
+	}
+
+	if (!r)
+	{
+		(void)m.deregister_native_handle(handle, reinterpret_cast<void*>(static_cast<uintptr_t>(slot) + 1));
+		return allio_ERROR(r.error());
+	}
+
+	return {};
+}
+
+} // namespace linux
 
 template<std::derived_from<platform_handle> Handle>
 struct allio::multiplexer_handle_implementation<linux::io_uring_multiplexer, Handle>
@@ -19,22 +53,82 @@ struct allio::multiplexer_handle_implementation<linux::io_uring_multiplexer, Han
 
 	static result<void> deregister_handle(linux::io_uring_multiplexer& m, Handle const& h)
 	{
-		return m.deregister_native_handle(h.get_platform_handle());
+		return m.deregister_native_handle(h.get_platform_handle(), h.get_multiplexer_data());
 	}
 };
 
 template<std::derived_from<platform_handle> Handle>
 struct multiplexer_handle_operation_implementation<linux::io_uring_multiplexer, Handle, io::close>
 {
-	using async_operation_storage = linux::io_uring_multiplexer::basic_async_operation_storage<io::close>;
+	struct async_operation_storage : linux::io_uring_multiplexer::basic_async_operation_storage<io::close>
+	{
+		using basic_async_operation_storage::basic_async_operation_storage;
+
+		int fd;
+
+		// Fixed file slot of a direct descriptor, plus one.
+		uint32_t file_index = 0;
+
+		linux::io_uring_multiplexer* multiplexer;
+	};
 
 	static result<void> start(linux::io_uring_multiplexer& m, async_operation_storage& s)
 	{
-		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+		if (linux::is_direct_handle(static_cast<Handle*>(s.handle)->get_platform_handle()))
+		{
+			// The direct descriptor is closed by clearing its slot using IORING_OP_CLOSE.
+			allio_TRY(slot, linux::io_uring_multiplexer::release_direct_handle(*static_cast<Handle*>(s.handle)));
+
+			s.file_index = slot + 1;
+			s.multiplexer = &m;
+
+			// No handle refers to the slot anymore, so it is released even if the close fails.
+			s.capture_completion([](async_operation_storage& s, int const result) -> allio::result<void>
+			{
+				if (result < 0)
+				{
+					// The slot is cleared in case the close was not performed.
+					(void)s.multiplexer->deregister_native_handle(linux::wrap_direct_handle(s.file_index - 1),
+						reinterpret_cast<void*>(static_cast<uintptr_t>(s.file_index)));
+
+					return allio_ERROR(std::error_code(-result, std::system_category()));
+				}
+
+				s.multiplexer->release_file_slot(s.file_index - 1);
+				return {};
+			});
+
+			result<void> const r = m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+			{
+				sqe.opcode = IORING_OP_CLOSE;
+				sqe.file_index = s.file_index;
+			});
+
+			if (!r)
+			{
+				// The slot is no longer owned by any handle, so it is cleared right away.
+				(void)m.deregister_native_handle(linux::wrap_direct_handle(slot), reinterpret_cast<void*>(static_cast<uintptr_t>(s.file_index)));
+				return allio_ERROR(r.error());
+			}
+
+			return {};
+		}
+
+		// Releasing the handle removes it from the fixed file table.
+		// IORING_OP_CLOSE does not accept fixed files.
+		allio_TRY(handle, static_cast<Handle*>(s.handle)->release_native_handle());
+
+		linux::unique_fd fd(linux::unwrap_handle(handle.handle));
+		s.fd = fd.get();
+
+		allio_TRYV(m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
 		{
 			sqe.opcode = IORING_OP_CLOSE;
-			sqe.fd = linux::unwrap_handle(static_cast<platform_handle*>(s.handle)->get_platform_handle());
-		});
+			sqe.fd = s.fd;
+		}));
+
+		(void)fd.release();
+		return {};
 	}
 
 	static result<void> cancel(linux::io_uring_multiplexer& m, async_operation_storage& s)
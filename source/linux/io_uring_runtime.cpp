@@ -0,0 +1,319 @@
+#include <allio/linux/io_uring_runtime.hpp>
+
+#include "error.hpp"
+
+#include <latch>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+
+#include <allio/linux/detail/undef.i>
+
+using namespace allio;
+using namespace allio::linux;
+
+struct io_uring_runtime::core
+{
+	// Read of the event, which completes when tasks are posted to an empty task list.
+	struct wake_operation : io_uring_multiplexer::async_operation_storage
+	{
+		int event;
+		eventfd_t value = 0;
+
+		explicit wake_operation(int const event)
+			: async_operation_storage(io_uring_multiplexer::message_parameters(), nullptr)
+			, event(event)
+		{
+		}
+	};
+
+	io_uring_runtime* runtime;
+	uint32_t index;
+	uint32_t cpu;
+
+	detail::unique_fd event;
+
+	// Stack of posted tasks, in reverse order of posting.
+	std::atomic<task*> tasks = nullptr;
+
+	// Destroyed after the multiplexer, which may still be reading into it.
+	std::optional<wake_operation> wake;
+
+	std::unique_ptr<io_uring_multiplexer> multiplexer;
+	std::error_code init_error;
+
+	std::thread thread;
+};
+
+thread_local io_uring_runtime::core* io_uring_runtime::s_current = nullptr;
+
+result<std::unique_ptr<io_uring_runtime>> io_uring_runtime::create(init_options const& options)
+{
+	std::vector<uint32_t> cpus = options.cpus;
+
+	if (cpus.empty())
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+
+		if (sched_getaffinity(0, sizeof(set), &set) == -1)
+		{
+			return allio_ERROR(get_last_error_code());
+		}
+
+		for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+		{
+			if (CPU_ISSET(cpu, &set))
+			{
+				cpus.push_back(cpu);
+			}
+		}
+	}
+
+	std::unique_ptr<io_uring_runtime> runtime(new io_uring_runtime());
+	runtime->m_cores.reserve(cpus.size());
+
+	for (uint32_t i = 0; i < cpus.size(); ++i)
+	{
+		int const event = eventfd(0, EFD_CLOEXEC);
+
+		if (event == -1)
+		{
+			return allio_ERROR(get_last_error_code());
+		}
+
+		auto& core = *runtime->m_cores.emplace_back(std::make_unique<io_uring_runtime::core>());
+		core.runtime = runtime.get();
+		core.index = i;
+		core.cpu = cpus[i];
+		core.event = detail::unique_fd(event);
+	}
+
+	std::latch initialized(static_cast<ptrdiff_t>(runtime->m_cores.size()));
+
+	for (auto const& core_ptr : runtime->m_cores)
+	{
+		core_ptr->thread = std::thread([&options, &initialized, &core = *core_ptr]()
+		{
+			// The multiplexer is created on its own thread, which becomes its single issuer if that mode is enabled.
+			auto const r = [&]() -> result<void>
+			{
+				if (options.enable_thread_affinity)
+				{
+					cpu_set_t set;
+					CPU_ZERO(&set);
+					CPU_SET(core.cpu, &set);
+
+					if (int const error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); error != 0)
+					{
+						return allio_ERROR(std::error_code(error, std::system_category()));
+					}
+				}
+
+				allio_TRY(init_result, io_uring_multiplexer::init(options.multiplexer_options));
+				core.multiplexer = std::make_unique<io_uring_multiplexer>(std::move(init_result));
+
+				return {};
+			}();
+
+			if (!r)
+			{
+				core.init_error = r.error();
+			}
+
+			initialized.count_down();
+
+			if (r)
+			{
+				core.runtime->run(core);
+			}
+		});
+	}
+
+	initialized.wait();
+
+	for (auto const& core : runtime->m_cores)
+	{
+		if (core->init_error)
+		{
+			return allio_ERROR(core->init_error);
+		}
+	}
+
+	return { result_value, std::move(runtime) };
+}
+
+io_uring_runtime::~io_uring_runtime()
+{
+	stop();
+
+	for (auto const& core : m_cores)
+	{
+		if (core->thread.joinable())
+		{
+			core->thread.join();
+		}
+	}
+
+	for (auto const& core : m_cores)
+	{
+		while (execute_tasks(*core, true));
+	}
+}
+
+uint32_t io_uring_runtime::get_cpu(uint32_t const core) const
+{
+	allio_ASSERT(core < m_cores.size());
+	return m_cores[core]->cpu;
+}
+
+io_uring_multiplexer& io_uring_runtime::get_multiplexer(uint32_t const core) const
+{
+	allio_ASSERT(core < m_cores.size());
+	return *m_cores[core]->multiplexer;
+}
+
+bool io_uring_runtime::post(uint32_t const core_index, task& task)
+{
+	allio_ASSERT(core_index < m_cores.size());
+
+	if (m_stop.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	core& core = *m_cores[core_index];
+
+	io_uring_runtime::task* head = core.tasks.load(std::memory_order_relaxed);
+	do
+	{
+		task.m_next = head;
+	}
+	while (!core.tasks.compare_exchange_weak(head, &task, std::memory_order_release, std::memory_order_relaxed));
+
+	// The thread is woken only by the first task posted since it last took the tasks.
+	if (head == nullptr)
+	{
+		wake(core);
+	}
+
+	return true;
+}
+
+void io_uring_runtime::stop()
+{
+	if (!m_stop.exchange(true, std::memory_order_acq_rel))
+	{
+		for (auto const& core : m_cores)
+		{
+			wake(*core);
+		}
+	}
+}
+
+io_uring_runtime* io_uring_runtime::get_current_runtime()
+{
+	return s_current != nullptr ? s_current->runtime : nullptr;
+}
+
+std::optional<uint32_t> io_uring_runtime::get_current_core()
+{
+	if (s_current == nullptr)
+	{
+		return std::nullopt;
+	}
+	return s_current->index;
+}
+
+result<listen_socket_handle> io_uring_runtime::listen(network_address const& address, listen_parameters const& args, socket_parameters const& create_args)
+{
+	if (s_current == nullptr)
+	{
+		return allio_ERROR(make_error_code(std::errc::operation_not_permitted));
+	}
+
+	listen_parameters listen_args = args;
+	listen_args.reuse_port = true;
+
+	socket_parameters socket_args = create_args;
+	socket_args.handle_flags |= flags::multiplexable;
+
+	result<listen_socket_handle> r = result_value;
+	allio_TRYV(r->create(address.kind(), socket_args));
+	allio_TRYV(r->set_multiplexer(s_current->multiplexer.get()));
+	allio_TRYV(r->listen(address, listen_args));
+	return r;
+}
+
+void io_uring_runtime::run(core& core)
+{
+	s_current = &core;
+
+	io_uring_multiplexer& multiplexer = *core.multiplexer;
+
+	while (!m_stop.load(std::memory_order_acquire))
+	{
+		if (!core.wake || core.wake->is_concluded())
+		{
+			// Operation state cannot be reused, so the wake operation is recreated after each completion.
+			core.wake.emplace(core.event.get());
+
+			auto const r = multiplexer.push(*core.wake, +[](core::wake_operation& storage, io_uring_sqe& sqe)
+			{
+				sqe.opcode = IORING_OP_READ;
+				sqe.fd = storage.event;
+				sqe.addr = reinterpret_cast<uintptr_t>(&storage.value);
+				sqe.len = sizeof(storage.value);
+			});
+
+			if (!r)
+			{
+				break;
+			}
+		}
+
+		if (!execute_tasks(core, false))
+		{
+			// If polling fails the thread stops, and its tasks are executed as stopped when the runtime is destroyed.
+			if (!multiplexer.submit_and_poll(deadline::never()))
+			{
+				break;
+			}
+		}
+	}
+
+	s_current = nullptr;
+}
+
+void io_uring_runtime::wake(core& core)
+{
+	allio_VERIFY(eventfd_write(core.event.get(), 1) != -1);
+}
+
+bool io_uring_runtime::execute_tasks(core& core, bool const stopped)
+{
+	task* head = core.tasks.exchange(nullptr, std::memory_order_acquire);
+
+	if (head == nullptr)
+	{
+		return false;
+	}
+
+	// Execute the tasks in the order they were posted.
+	task* previous = nullptr;
+	while (head != nullptr)
+	{
+		previous = std::exchange(head, std::exchange(head->m_next, previous));
+	}
+
+	while (previous != nullptr)
+	{
+		// The task may be destroyed when executed.
+		task& task = *std::exchange(previous, previous->m_next);
+		task.m_execute(task, stopped);
+	}
+
+	return true;
+}
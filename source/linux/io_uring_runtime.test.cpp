@@ -0,0 +1,100 @@
+#include <allio/linux/io_uring_runtime.hpp>
+
+#include <unifex/just.hpp>
+#include <unifex/just_from.hpp>
+#include <unifex/sync_wait.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace allio;
+using namespace allio::linux;
+
+static std::unique_ptr<io_uring_runtime> create_runtime(io_uring_runtime::init_options const& options = {})
+{
+	auto create_result = io_uring_runtime::create(options);
+	if (!create_result)
+	{
+		SKIP("io_uring is not available");
+	}
+	return std::move(*create_result);
+}
+
+TEST_CASE("io_uring_runtime::on", "[io_uring_runtime]")
+{
+	auto const runtime = create_runtime();
+
+	REQUIRE(io_uring_runtime::get_current_runtime() == nullptr);
+	REQUIRE(!io_uring_runtime::get_current_core());
+
+	// The sender is started on the thread of the core.
+	for (uint32_t core = 0; core < runtime->get_core_count(); ++core)
+	{
+		auto const current = unifex::sync_wait(runtime->on(core, unifex::just_from([]()
+		{
+			return std::pair(io_uring_runtime::get_current_runtime(), io_uring_runtime::get_current_core());
+		})));
+
+		REQUIRE(current);
+		REQUIRE(current->first == runtime.get());
+		REQUIRE(current->second == core);
+	}
+}
+
+TEST_CASE("io_uring_runtime::stop", "[io_uring_runtime]")
+{
+	auto const runtime = create_runtime();
+
+	REQUIRE(unifex::sync_wait(runtime->on(0, unifex::just())));
+
+	runtime->stop();
+
+	// Senders scheduled after stopping complete as done.
+	REQUIRE(!unifex::sync_wait(runtime->on(0, unifex::just())));
+}
+
+TEST_CASE("io_uring_runtime::listen", "[io_uring_runtime]")
+{
+	network_address const address = ipv4_address::localhost(51241);
+
+	auto const runtime = create_runtime();
+	uint32_t const core_count = runtime->get_core_count();
+
+	// Only the thread of a core may listen.
+	REQUIRE(io_uring_runtime::listen(address).error() == std::errc::operation_not_permitted);
+
+	// Each core listens on the same address.
+	std::vector<listen_socket_handle> sockets(core_count);
+	for (uint32_t core = 0; core < core_count; ++core)
+	{
+		auto const error = unifex::sync_wait(runtime->on(core, unifex::just_from([&]() -> std::error_code
+		{
+			auto listen_result = io_uring_runtime::listen(address);
+			if (!listen_result)
+			{
+				return listen_result.error();
+			}
+			sockets[core] = std::move(*listen_result);
+			return {};
+		})));
+
+		REQUIRE(error);
+		REQUIRE(!*error);
+	}
+
+	// The sockets are bound to the multiplexers of their cores, so they are closed on the same threads.
+	for (uint32_t core = 0; core < core_count; ++core)
+	{
+		auto const error = unifex::sync_wait(runtime->on(core, unifex::just_from([&]() -> std::error_code
+		{
+			auto const close_result = sockets[core].close();
+			return close_result ? std::error_code() : close_result.error();
+		})));
+
+		REQUIRE(error);
+		REQUIRE(!*error);
+	}
+}
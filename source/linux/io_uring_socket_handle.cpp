@@ -49,7 +49,7 @@ struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer,
 		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
 		{
 			sqe.opcode = IORING_OP_CONNECT;
-			sqe.fd = unwrap_socket(s.handle->get_platform_handle());
+			io_uring_multiplexer::set_file(sqe, *s.handle);
 			sqe.addr = reinterpret_cast<uintptr_t>(&s.addr.addr);
 			sqe.off = s.addr.size;
 		});
@@ -61,6 +61,132 @@ struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer,
 	}
 };
 
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, socket_handle, io::stream_write_zero_copy>
+{
+	struct async_operation_storage : scatter_gather_async_operation_storage
+	{
+		using scatter_gather_async_operation_storage::scatter_gather_async_operation_storage;
+
+		msghdr message;
+	};
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			auto const buffers = s.buffers.buffers();
+
+			io_uring_multiplexer::set_file(sqe, *static_cast<platform_handle const*>(s.handle));
+
+			if (buffers.size() == 1)
+			{
+				sqe.opcode = IORING_OP_SEND_ZC;
+				sqe.addr = reinterpret_cast<uintptr_t>(buffers[0].data());
+				sqe.len = buffers[0].size();
+
+				if (s.buffers.is_registered())
+				{
+					sqe.ioprio = IORING_RECVSEND_FIXED_BUF;
+					sqe.buf_index = s.buffers.registered_index();
+				}
+			}
+			else
+			{
+				// untyped_buffer is layout compatible with iovec.
+				s.message = {};
+				s.message.msg_iov = reinterpret_cast<iovec*>(const_cast<untyped_buffer*>(buffers.data()));
+				s.message.msg_iovlen = buffers.size();
+
+				sqe.opcode = IORING_OP_SENDMSG_ZC;
+				sqe.addr = reinterpret_cast<uintptr_t>(&s.message);
+			}
+
+			// The send completion carries the result, while the notification signals that the buffers are released.
+			s.await_notification();
+
+			s.capture_result([](async_operation_storage& s, int const result)
+			{
+				*s.transferred = static_cast<size_t>(result);
+			});
+		});
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, socket_handle, io::stream_read_provided>
+{
+	struct async_operation_storage : io_uring_multiplexer::basic_async_operation_storage<io::stream_read_provided>
+	{
+		using basic_async_operation_storage::basic_async_operation_storage;
+
+		io_uring_multiplexer::buffer_group const* group;
+	};
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		allio_TRYA(s.group, m.find_buffer_group(s.buffer_group));
+
+		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			sqe.opcode = IORING_OP_RECV;
+			io_uring_multiplexer::set_file(sqe, static_cast<platform_handle const&>(*s.handle));
+			sqe.flags |= IOSQE_BUFFER_SELECT;
+			sqe.buf_group = s.buffer_group;
+
+			s.capture_result([](async_operation_storage& s, int const result)
+			{
+				*s.result = s.group->get_buffer(s.get_cqe_flags(), static_cast<size_t>(result));
+			});
+		});
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, socket_handle, io::multishot_stream_read_provided>
+{
+	struct async_operation_storage : io_uring_multiplexer::basic_async_operation_storage<io::multishot_stream_read_provided>
+	{
+		using basic_async_operation_storage::basic_async_operation_storage;
+
+		io_uring_multiplexer::buffer_group const* group;
+	};
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		allio_TRYA(s.group, m.find_buffer_group(s.buffer_group));
+
+		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			sqe.opcode = IORING_OP_RECV;
+			io_uring_multiplexer::set_file(sqe, static_cast<platform_handle const&>(*s.handle));
+			sqe.ioprio = IORING_RECV_MULTISHOT;
+			sqe.flags |= IOSQE_BUFFER_SELECT;
+			sqe.buf_group = s.buffer_group;
+
+			s.capture_result([](async_operation_storage& s, int const result)
+			{
+				*s.result = s.group->get_buffer(s.get_cqe_flags(), static_cast<size_t>(result));
+			});
+		});
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
 template<>
 struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, listen_socket_handle, io::listen>
 {
@@ -84,20 +210,45 @@ struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer,
 	{
 		using basic_async_operation_storage::basic_async_operation_storage;
 
+		io_uring_multiplexer* multiplexer;
 		socket_address addr;
 	};
 
 	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
 	{
+		if ((s.create_args.handle_flags & flags::multiplexer_bound) != flags::none && !m.has_direct_file_allocation())
+		{
+			return allio_ERROR(make_error_code(std::errc::not_supported));
+		}
+
+		s.multiplexer = &m;
+
 		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
 		{
 			s.addr.size = sizeof(socket_address_union);
 
 			sqe.opcode = IORING_OP_ACCEPT;
-			sqe.fd = unwrap_socket(s.handle->get_platform_handle());
+			io_uring_multiplexer::set_file(sqe, *s.handle);
 			sqe.addr = reinterpret_cast<uintptr_t>(&s.addr.addr);
 			sqe.addr2 = reinterpret_cast<uintptr_t>(&s.addr.size);
 
+			if ((s.create_args.handle_flags & flags::multiplexer_bound) != flags::none)
+			{
+				// The accepted socket never enters the process file descriptor table.
+				sqe.file_index = IORING_FILE_INDEX_ALLOC;
+
+				s.capture_result([](async_operation_storage& s, int const result) -> allio::result<void>
+				{
+					allio_ASSERT(!s.result->socket);
+					allio_TRYV(consume_direct_handle(*s.multiplexer,
+						s.result->socket, { s.create_args.handle_flags }, static_cast<uint32_t>(result)));
+					s.result->address = s.addr.get_network_address();
+					return {};
+				});
+
+				return;
+			}
+
 			s.capture_result([](async_operation_storage& s, int const result) -> allio::result<void>
 			{
 				allio_ASSERT(!s.result->socket);
@@ -114,5 +265,51 @@ struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer,
 	}
 };
 
+template<>
+struct allio::multiplexer_handle_operation_implementation<io_uring_multiplexer, listen_socket_handle, io::multishot_accept>
+{
+	using async_operation_storage = io_uring_multiplexer::basic_async_operation_storage<io::multishot_accept>;
+
+	static result<void> start(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		// The peer address of a direct descriptor cannot be queried.
+		if ((s.create_args.handle_flags & flags::multiplexer_bound) != flags::none)
+		{
+			return allio_ERROR(make_error_code(std::errc::not_supported));
+		}
+
+		return m.push(s, +[](async_operation_storage& s, io_uring_sqe& sqe)
+		{
+			sqe.opcode = IORING_OP_ACCEPT;
+			io_uring_multiplexer::set_file(sqe, *s.handle);
+			sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+
+			// The address buffer would be shared by all accepts, so the peer address is queried separately.
+			s.capture_result([](async_operation_storage& s, int const result) -> allio::result<void>
+			{
+				unique_socket socket(result);
+
+				socket_address addr;
+				addr.size = sizeof(socket_address_union);
+
+				if (getpeername(socket.get(), &addr.addr, &addr.size))
+				{
+					return allio_ERROR(get_last_socket_error());
+				}
+
+				allio_ASSERT(!s.result->socket);
+				allio_TRYV(consume_socket_handle(s.result->socket, { s.create_args.handle_flags }, std::move(socket)));
+				s.result->address = addr.get_network_address();
+				return {};
+			});
+		});
+	}
+
+	static result<void> cancel(io_uring_multiplexer& m, async_operation_storage& s)
+	{
+		return m.cancel(s);
+	}
+};
+
 allio_MULTIPLEXER_HANDLE_RELATION(io_uring_multiplexer, socket_handle);
 allio_MULTIPLEXER_HANDLE_RELATION(io_uring_multiplexer, listen_socket_handle);
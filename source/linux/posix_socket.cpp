@@ -26,7 +26,7 @@ result<unique_socket> allio::create_socket(int const address_family, flags const
 
 result<unique_socket> allio::accept_socket(socket_type const listen_socket, socket_address& addr, socket_parameters const& create_args)
 {
-	socket_type const socket = ::accept(socket, &addr.addr, &addr.size);
+	socket_type const socket = ::accept(listen_socket, &addr.addr, &addr.size);
 
 	if (socket == invalid_socket)
 	{
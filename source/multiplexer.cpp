@@ -46,6 +46,16 @@ result<void> multiplexer::cancel(async_operation_descriptor const& descriptor, a
 	return descriptor.cancel(*this, operation);
 }
 
+result<void> multiplexer::begin_chain(chain_mode const mode)
+{
+	return allio_ERROR(make_error_code(std::errc::not_supported));
+}
+
+result<void> multiplexer::end_chain()
+{
+	return allio_ERROR(make_error_code(std::errc::not_supported));
+}
+
 result<void> multiplexer::submit(deadline const deadline)
 {
 	return {};
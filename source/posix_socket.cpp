@@ -112,6 +112,19 @@ result<void> allio::listen_socket(socket_type const socket, network_address cons
 
 	allio_TRY(addr, socket_address::make(address));
 
+	if (args.reuse_port)
+	{
+#ifdef SO_REUSEPORT
+		int const value = 1;
+		if (::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<char const*>(&value), sizeof(value)))
+		{
+			return allio_ERROR(get_last_socket_error());
+		}
+#else
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+#endif
+	}
+
 	if (::bind(socket, &addr.addr, addr.size))
 	{
 		return allio_ERROR(get_last_socket_error());
@@ -153,6 +166,11 @@ result<accept_result> detail::listen_socket_handle_base::accept_sync(socket_para
 {
 	allio_ASSERT(*this);
 
+	if ((create_args.handle_flags & flags::multiplexer_bound) != flags::none)
+	{
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+
 	socket_address addr;
 	allio_TRY(socket, accept_socket(unwrap_socket(get_platform_handle()), addr, create_args));
 
@@ -4,13 +4,26 @@
 #include <allio/path.hpp>
 #include <allio/sync_wait.hpp>
 
+#include <unifex/inplace_stop_token.hpp>
+#include <unifex/just.hpp>
+#include <unifex/let_done.hpp>
 #include <unifex/task.hpp>
 #include <unifex/when_all.hpp>
+#include <unifex/with_query_value.hpp>
 
 #include <catch2/catch_all.hpp>
 
+#if allio_detail_LINUX
+#	include <allio/linux/epoll_multiplexer.hpp>
+#	include <allio/linux/io_uring_multiplexer.hpp>
+
+#	include "linux/io_uring_platform_handle.hpp"
+#endif
+
+#include <cstring>
 #include <filesystem>
 #include <type_traits>
+#include <vector>
 
 using namespace allio;
 
@@ -74,3 +87,419 @@ TEST_CASE("socket_handle localhost server & client", "[socket_handle]")
 		);
 	}()).value();
 }
+
+TEST_CASE("socket_handle::close_async", "[socket_handle]")
+{
+	network_address const address = ipv4_address::localhost(51238);
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		listen_socket_handle listen_socket = co_await listen_async(*multiplexer, address);
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = (co_await listen_socket.accept_async()).socket;
+				socket.set_multiplexer(multiplexer.get());
+
+				// The peer observes the close as the end of the stream.
+				int data;
+				REQUIRE(co_await socket.read_async(as_read_buffer(&data, 1)) == 0);
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = co_await connect_async(*multiplexer, address);
+
+				co_await socket.close_async();
+				REQUIRE(!socket);
+			}()
+		);
+	}()).value();
+}
+
+#if allio_detail_LINUX
+TEST_CASE("socket_handle zero copy write", "[socket_handle]")
+{
+	network_address const address = ipv4_address::localhost(51235);
+
+	unique_multiplexer const multiplexer = create_default_multiplexer().value();
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		listen_socket_handle listen_socket = co_await listen_async(*multiplexer, address);
+
+		std::byte data[0x10000];
+		for (size_t i = 0; i < sizeof(data); ++i)
+		{
+			data[i] = static_cast<std::byte>(i * 7);
+		}
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = (co_await listen_socket.accept_async()).socket;
+				socket.set_multiplexer(multiplexer.get());
+
+				std::byte received[sizeof(data)];
+				size_t received_size = 0;
+
+				while (received_size < sizeof(received))
+				{
+					size_t const size = co_await socket.read_async(read_buffer(received + received_size, sizeof(received) - received_size));
+					REQUIRE(size != 0);
+					received_size += size;
+				}
+
+				REQUIRE(std::memcmp(received, data, sizeof(data)) == 0);
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = co_await connect_async(*multiplexer, address);
+
+				// The data is not modified until the kernel has released it.
+				size_t sent_size = 0;
+				while (sent_size < sizeof(data))
+				{
+					sent_size += co_await socket.write_zero_copy_async(write_buffer(data + sent_size, sizeof(data) - sent_size));
+				}
+			}()
+		);
+	}()).value();
+}
+
+TEST_CASE("socket_handle epoll multiplexer", "[socket_handle]")
+{
+	network_address const address = ipv4_address::localhost(51236);
+
+	unique_multiplexer const multiplexer = std::make_unique<linux::epoll_multiplexer>(
+		linux::epoll_multiplexer::init({}).value());
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		listen_socket_handle listen_socket = co_await listen_async(*multiplexer, address);
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = (co_await listen_socket.accept_async()).socket;
+				socket.set_multiplexer(multiplexer.get());
+
+				int request_data;
+				REQUIRE(co_await socket.read_async(as_read_buffer(&request_data, 1)) == sizeof(request_data));
+
+				int const reply_data = -request_data;
+				REQUIRE(co_await socket.write_async(as_write_buffer(&reply_data, 1)) == sizeof(reply_data));
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = co_await connect_async(*multiplexer, address);
+
+				int const request_data = 42;
+				REQUIRE(co_await socket.write_async(as_write_buffer(&request_data, 1)) == sizeof(request_data));
+
+				int reply_data;
+				REQUIRE(co_await socket.read_async(as_read_buffer(&reply_data, 1)) == sizeof(reply_data));
+
+				REQUIRE(reply_data == -request_data);
+			}()
+		);
+	}()).value();
+}
+
+TEST_CASE("socket_handle multishot accept cancellation", "[socket_handle]")
+{
+	network_address const address = ipv4_address::localhost(51237);
+
+	auto io_uring_result = linux::io_uring_multiplexer::init({});
+	if (!io_uring_result)
+	{
+		SKIP("io_uring is not available");
+	}
+
+	unique_multiplexer const multiplexer = std::make_unique<linux::io_uring_multiplexer>(std::move(*io_uring_result));
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		listen_socket_handle listen_socket = co_await listen_async(*multiplexer, address);
+
+		unifex::inplace_stop_source stop_source;
+		std::vector<socket_handle> sockets;
+		bool stopped = false;
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				auto accept = listen_socket.multishot_accept_async([&](result<accept_result>&& result)
+				{
+					REQUIRE(result);
+					sockets.push_back(std::move(result->socket));
+
+					// The operation remains armed until stop is requested.
+					if (sockets.size() == 2)
+					{
+						stop_source.request_stop();
+					}
+				});
+
+				co_await unifex::let_done(
+					unifex::with_query_value(std::move(accept), unifex::get_stop_token, stop_source.get_token()),
+					[&]()
+					{
+						stopped = true;
+						return unifex::just();
+					});
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				socket_handle const socket_1 = co_await connect_async(*multiplexer, address);
+				socket_handle const socket_2 = co_await connect_async(*multiplexer, address);
+			}()
+		);
+
+		REQUIRE(stopped);
+		REQUIRE(sockets.size() == 2);
+	}()).value();
+}
+
+TEST_CASE("socket_handle::read_provided_async", "[socket_handle]")
+{
+	network_address const address = ipv4_address::localhost(51239);
+
+	auto io_uring_result = linux::io_uring_multiplexer::init({});
+	if (!io_uring_result)
+	{
+		SKIP("io_uring is not available");
+	}
+
+	auto const multiplexer = std::make_unique<linux::io_uring_multiplexer>(std::move(*io_uring_result));
+
+	auto const buffer_group = multiplexer->create_buffer_group(4, 64);
+	if (!buffer_group)
+	{
+		SKIP("Provided buffer rings are not available");
+	}
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		listen_socket_handle listen_socket = co_await listen_async(*multiplexer, address);
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = (co_await listen_socket.accept_async()).socket;
+				socket.set_multiplexer(multiplexer.get());
+
+				// The buffer is selected from the group by the kernel when the data arrives.
+				provided_buffer const buffer = co_await socket.read_provided_async(*buffer_group);
+				REQUIRE(buffer);
+				REQUIRE(buffer.group == *buffer_group);
+				REQUIRE(buffer.size == 5);
+				REQUIRE(memcmp(buffer.data, "allio", 5) == 0);
+
+				multiplexer->release_provided_buffer(buffer);
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = co_await connect_async(*multiplexer, address);
+				REQUIRE(co_await socket.write_async(as_write_buffer("allio", 5)) == 5);
+			}()
+		);
+	}()).value();
+
+	multiplexer->destroy_buffer_group(*buffer_group).value();
+}
+
+TEST_CASE("socket_handle::multishot_read_provided_async", "[socket_handle]")
+{
+	network_address const address = ipv4_address::localhost(51242);
+
+	auto io_uring_result = linux::io_uring_multiplexer::init({});
+	if (!io_uring_result)
+	{
+		SKIP("io_uring is not available");
+	}
+
+	auto const multiplexer = std::make_unique<linux::io_uring_multiplexer>(std::move(*io_uring_result));
+
+	auto const buffer_group = multiplexer->create_buffer_group(4, 64);
+	if (!buffer_group)
+	{
+		SKIP("Provided buffer rings are not available");
+	}
+
+	// Three messages of 40 bytes do not fit in a single 64 byte buffer.
+	std::byte data[3][40];
+	for (size_t i = 0; i < std::size(data); ++i)
+	{
+		for (size_t j = 0; j < std::size(data[i]); ++j)
+		{
+			data[i][j] = static_cast<std::byte>(i * 64 + j);
+		}
+	}
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		listen_socket_handle listen_socket = co_await listen_async(*multiplexer, address);
+
+		socket_handle server_socket;
+		unifex::inplace_stop_source stop_source;
+		size_t buffer_count = 0;
+		size_t received_size = 0;
+		bool stopped = false;
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				server_socket = (co_await listen_socket.accept_async()).socket;
+				server_socket.set_multiplexer(multiplexer.get());
+
+				auto read = server_socket.multishot_read_provided_async([&](result<provided_buffer>&& result)
+				{
+					REQUIRE(result);
+					provided_buffer const buffer = *result;
+					REQUIRE(buffer);
+					REQUIRE(buffer.group == *buffer_group);
+					REQUIRE(buffer.size != 0);
+					REQUIRE(buffer.size <= 64);
+					REQUIRE(received_size + buffer.size <= sizeof(data));
+
+					// Each buffer holds the next contiguous part of the stream.
+					REQUIRE(std::memcmp(buffer.data, reinterpret_cast<std::byte const*>(data) + received_size, buffer.size) == 0);
+
+					received_size += buffer.size;
+					++buffer_count;
+
+					// The buffer is returned to the ring for the following receives.
+					multiplexer->release_provided_buffer(buffer);
+
+					if (received_size == sizeof(data))
+					{
+						stop_source.request_stop();
+					}
+				}, *buffer_group);
+
+				co_await unifex::let_done(
+					unifex::with_query_value(std::move(read), unifex::get_stop_token, stop_source.get_token()),
+					[&]()
+					{
+						stopped = true;
+						return unifex::just();
+					});
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				socket_handle socket = co_await connect_async(*multiplexer, address);
+
+				for (auto const& message : data)
+				{
+					REQUIRE(co_await socket.write_async(write_buffer(message, sizeof(message))) == sizeof(message));
+				}
+			}()
+		);
+
+		REQUIRE(stopped);
+		REQUIRE(received_size == sizeof(data));
+		REQUIRE(buffer_count >= 2);
+	}()).value();
+
+	multiplexer->destroy_buffer_group(*buffer_group).value();
+}
+
+TEST_CASE("socket_handle multiplexer bound accept", "[socket_handle]")
+{
+	network_address const address = ipv4_address::localhost(51243);
+
+	// With a single slot, each accept succeeds only if the previous direct descriptor released its slot.
+	auto io_uring_result = linux::io_uring_multiplexer::init({ .direct_file_table_size = 1 });
+	if (!io_uring_result)
+	{
+		SKIP("io_uring is not available");
+	}
+
+	auto const multiplexer = std::make_unique<linux::io_uring_multiplexer>(std::move(*io_uring_result));
+
+	if (!multiplexer->has_direct_file_allocation())
+	{
+		SKIP("Direct descriptor allocation is not available");
+	}
+
+	socket_parameters const bound_args = { .handle_flags = flags::multiplexer_bound };
+
+	sync_wait(*multiplexer, [&]() -> unifex::task<void>
+	{
+		listen_socket_handle listen_socket = co_await listen_async(*multiplexer, address);
+
+		auto const exchange = [&](int const request_data) -> unifex::task<void>
+		{
+			co_await unifex::when_all(
+				[&]() -> unifex::task<void>
+				{
+					socket_handle socket = (co_await listen_socket.accept_async(bound_args)).socket;
+					REQUIRE(linux::is_direct_handle(socket.get_platform_handle()));
+					REQUIRE(socket.get_multiplexer() == multiplexer.get());
+
+					int data;
+					REQUIRE(co_await socket.read_async(as_read_buffer(&data, 1)) == sizeof(data));
+					REQUIRE(data == request_data);
+
+					int const reply_data = -data;
+					REQUIRE(co_await socket.write_async(as_write_buffer(&reply_data, 1)) == sizeof(reply_data));
+
+					// Closing the direct descriptor clears its slot.
+					co_await socket.close_async();
+					REQUIRE(!socket);
+				}(),
+
+				[&]() -> unifex::task<void>
+				{
+					socket_handle socket = co_await connect_async(*multiplexer, address);
+					REQUIRE(co_await socket.write_async(as_write_buffer(&request_data, 1)) == sizeof(request_data));
+
+					int reply_data;
+					REQUIRE(co_await socket.read_async(as_read_buffer(&reply_data, 1)) == sizeof(reply_data));
+					REQUIRE(reply_data == -request_data);
+				}()
+			);
+		};
+
+		co_await exchange(1);
+		co_await exchange(2);
+
+		socket_handle server_socket;
+		socket_handle client_socket;
+
+		co_await unifex::when_all(
+			[&]() -> unifex::task<void>
+			{
+				server_socket = (co_await listen_socket.accept_async(bound_args)).socket;
+			}(),
+
+			[&]() -> unifex::task<void>
+			{
+				client_socket = co_await connect_async(*multiplexer, address);
+			}()
+		);
+
+		// Take over the slot of the accepted socket without clearing it.
+		uint32_t const slot = linux::io_uring_multiplexer::release_direct_handle(server_socket).value();
+		REQUIRE(!server_socket);
+
+		// Attaching the slot to a handle which is not null fails and clears the slot.
+		auto const r = linux::consume_direct_handle(*multiplexer, client_socket,
+			{ flags::multiplexable | flags::multiplexer_bound }, slot);
+		REQUIRE(!r);
+		REQUIRE(r.error() == make_error_code(error::handle_is_not_null));
+		REQUIRE(client_socket);
+
+		co_await exchange(3);
+	}()).value();
+}
+#endif
@@ -3,9 +3,13 @@
 #include <allio/win32/kernel_error.hpp>
 
 #include "api_string.hpp"
+#include "error.hpp"
 #include "filesystem_handle.hpp"
 #include "kernel.hpp"
 
+#include <algorithm>
+#include <memory>
+
 using namespace allio;
 using namespace allio::win32;
 
@@ -66,3 +70,189 @@ result<size_t> detail::file_handle_base::write_at_sync(file_offset const offset,
 	allio_ASSERT(*this);
 	return scatter_gather_at(offset, buffers, unwrap_handle(get_platform_handle()), NtWriteFile);
 }
+
+result<size_t> detail::file_handle_base::transfer_to_sync(file_offset const offset, size_t const size, platform_handle const& target)
+{
+	allio_ASSERT(*this);
+	allio_TRYV(kernel_init());
+
+	// The data is copied through a buffer, so a single transfer is limited to its size.
+	static constexpr size_t max_transfer_size = 64 * 1024;
+
+	size_t const buffer_size = std::min(size, max_transfer_size);
+	std::unique_ptr<std::byte[]> const buffer(new std::byte[buffer_size]);
+
+	read_buffer const source_buffer(buffer.get(), buffer_size);
+	allio_TRY(read_size, scatter_gather_at(offset, read_buffers(&source_buffer, 1), unwrap_handle(get_platform_handle()), NtReadFile));
+
+	HANDLE const target_handle = unwrap_handle(target.get_platform_handle());
+
+	// Like on other platforms, the data is written at the current position of the target.
+	LARGE_INTEGER target_offset;
+	target_offset.HighPart = -1;
+	target_offset.LowPart = static_cast<DWORD>(-2); // FILE_USE_FILE_POINTER_POSITION
+
+	size_t written = 0;
+	while (written != read_size)
+	{
+		IO_STATUS_BLOCK isb = make_io_status_block();
+
+		NTSTATUS status = NtWriteFile(
+			target_handle,
+			NULL,
+			nullptr,
+			nullptr,
+			&isb,
+			buffer.get() + written,
+			static_cast<ULONG>(read_size - written),
+			&target_offset,
+			0);
+
+		if (status == STATUS_PENDING)
+		{
+			status = io_wait(target_handle, &isb, deadline());
+		}
+
+		if (status < 0)
+		{
+			// Data already written to the target is reported as transferred.
+			if (written != 0)
+			{
+				break;
+			}
+			return allio_ERROR(static_cast<kernel_error>(status));
+		}
+
+		if (isb.Information == 0)
+		{
+			break;
+		}
+
+		written += isb.Information;
+	}
+
+	return written;
+}
+
+result<file_offset> detail::file_handle_base::flush_sync(file_flush_mode const mode, flush_parameters const& args)
+{
+	allio_ASSERT(*this);
+
+	HANDLE const handle = unwrap_handle(get_platform_handle());
+
+	// Writes completed before the size is sampled are covered by the flush.
+	LARGE_INTEGER size = {};
+	if (args.sample_size && !GetFileSizeEx(handle, &size))
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	allio_TRYV(kernel_init());
+
+	IO_STATUS_BLOCK isb = make_io_status_block();
+
+	NTSTATUS const status = NtFlushBuffersFileEx(
+		handle,
+		mode == file_flush_mode::data ? FLUSH_FLAGS_FILE_DATA_SYNC_ONLY : 0,
+		nullptr,
+		0,
+		&isb);
+
+	if (status < 0)
+	{
+		return allio_ERROR(static_cast<kernel_error>(status));
+	}
+
+	return static_cast<file_offset>(size.QuadPart);
+}
+
+result<file_offset> detail::file_handle_base::flush_range_sync(file_offset const offset, uint64_t const size)
+{
+	allio_ASSERT(*this);
+
+	// Ranges are not supported, so the whole file is flushed.
+	if (!FlushFileBuffers(unwrap_handle(get_platform_handle())))
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return offset + size;
+}
+
+static result<void> set_end_of_file(HANDLE const handle, file_offset const size)
+{
+	FILE_END_OF_FILE_INFO info;
+	info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+
+	if (!SetFileInformationByHandle(handle, FileEndOfFileInfo, &info, sizeof(info)))
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	return {};
+}
+
+result<void> detail::file_handle_base::allocate_sync(file_allocation_mode const mode, file_offset const offset, uint64_t const size)
+{
+	allio_ASSERT(*this);
+
+	HANDLE const handle = unwrap_handle(get_platform_handle());
+	file_offset const end = offset + size;
+
+	FILE_STANDARD_INFO standard_info;
+	if (!GetFileInformationByHandleEx(handle, FileStandardInfo, &standard_info, sizeof(standard_info)))
+	{
+		return allio_ERROR(get_last_error_code());
+	}
+
+	switch (mode)
+	{
+	case file_allocation_mode::allocate:
+	case file_allocation_mode::keep_size:
+		// Allocation is always from the start of the file, and is never reduced here.
+		if (static_cast<file_offset>(standard_info.AllocationSize.QuadPart) < end)
+		{
+			FILE_ALLOCATION_INFO allocation_info;
+			allocation_info.AllocationSize.QuadPart = static_cast<LONGLONG>(end);
+
+			if (!SetFileInformationByHandle(handle, FileAllocationInfo, &allocation_info, sizeof(allocation_info)))
+			{
+				return allio_ERROR(get_last_error_code());
+			}
+		}
+		break;
+
+	case file_allocation_mode::punch_hole:
+	case file_allocation_mode::zero_range:
+		{
+			// The range is deallocated if the file is sparse, and otherwise filled with zeros.
+			FILE_ZERO_DATA_INFORMATION zero_info;
+			zero_info.FileOffset.QuadPart = static_cast<LONGLONG>(offset);
+			zero_info.BeyondFinalZero.QuadPart = static_cast<LONGLONG>(end);
+
+			DWORD bytes_returned;
+			if (!DeviceIoControl(handle, FSCTL_SET_ZERO_DATA, &zero_info, sizeof(zero_info), nullptr, 0, &bytes_returned, nullptr))
+			{
+				return allio_ERROR(get_last_error_code());
+			}
+		}
+		break;
+
+	default:
+		return allio_ERROR(make_error_code(std::errc::invalid_argument));
+	}
+
+	if ((mode == file_allocation_mode::allocate || mode == file_allocation_mode::zero_range) &&
+		static_cast<file_offset>(standard_info.EndOfFile.QuadPart) < end)
+	{
+		allio_TRYV(set_end_of_file(handle, end));
+	}
+
+	return {};
+}
+
+result<void> detail::file_handle_base::set_size_sync(file_offset const size)
+{
+	allio_ASSERT(*this);
+	return set_end_of_file(unwrap_handle(get_platform_handle()), size);
+}
@@ -72,6 +72,24 @@ result<unique_handle> win32::create_file(filesystem_handle const* const base, pa
 		break;
 	}
 
+	switch (args.caching)
+	{
+	case file_caching::cached:
+		break;
+
+	case file_caching::write_through:
+		create_options |= FILE_WRITE_THROUGH;
+		break;
+
+	case file_caching::unbuffered:
+		create_options |= FILE_NO_INTERMEDIATE_BUFFERING;
+		break;
+
+	case file_caching::unbuffered_write_through:
+		create_options |= FILE_NO_INTERMEDIATE_BUFFERING | FILE_WRITE_THROUGH;
+		break;
+	}
+
 	api_string nt_path;
 	nt_path.append(L"\\??\\");
 	nt_path.append(path);
@@ -89,7 +107,7 @@ result<unique_handle> win32::create_file(filesystem_handle const* const base, pa
 	oa.ObjectName = &unicode_string;
 
 	LARGE_INTEGER allocation_size;
-	allocation_size.QuadPart = 0;
+	allocation_size.QuadPart = static_cast<LONGLONG>(args.allocation_size);
 
 	IO_STATUS_BLOCK isb = make_io_status_block();
 
@@ -88,6 +88,25 @@ result<multiplexer_handle_relation const*> iocp_multiplexer::find_handle_relatio
 	return static_multiplexer_handle_relation_provider<iocp_multiplexer, async_handle_types>::find_handle_relation(handle_type);
 }
 
+result<async_operation*> iocp_multiplexer::construct(async_operation_descriptor const& descriptor, storage_ptr const storage, async_operation_parameters const& arguments, async_operation_listener* const listener)
+{
+	// Operation deadlines are not implemented on IOCP.
+	if (arguments.deadline != deadline::never())
+	{
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+	return multiplexer::construct(descriptor, storage, arguments, listener);
+}
+
+result<async_operation*> iocp_multiplexer::construct_and_start(async_operation_descriptor const& descriptor, storage_ptr const storage, async_operation_parameters const& arguments, async_operation_listener* const listener)
+{
+	if (arguments.deadline != deadline::never())
+	{
+		return allio_ERROR(make_error_code(std::errc::not_supported));
+	}
+	return multiplexer::construct_and_start(descriptor, storage, arguments, listener);
+}
+
 result<void> iocp_multiplexer::submit(deadline const deadline)
 {
 	return {};
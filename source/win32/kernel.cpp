@@ -15,6 +15,7 @@ using namespace allio::win32;
 	X(NtReadFile,                       ntdll       __VA_OPT__(, __VA_ARGS__)) \
 	X(NtWriteFile,                      ntdll       __VA_OPT__(, __VA_ARGS__)) \
 	X(NtCancelIoFileEx,                 ntdll       __VA_OPT__(, __VA_ARGS__)) \
+	X(NtFlushBuffersFileEx,             ntdll       __VA_OPT__(, __VA_ARGS__)) \
 	X(NtRemoveIoCompletion,             ntdll       __VA_OPT__(, __VA_ARGS__)) \
 
 #define allio_X(syscall, ...) \
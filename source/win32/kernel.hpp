@@ -170,6 +170,16 @@ extern NTSTATUS(NTAPI *NtCancelIoFileEx)(
 	_Out_ PIO_STATUS_BLOCK IoRequestToCancel,
 	_Out_ PIO_STATUS_BLOCK IoStatusBlock);
 
+// Flush only the data and the metadata needed to read it back.
+inline constexpr ULONG FLUSH_FLAGS_FILE_DATA_SYNC_ONLY          = 0x00000004;
+
+extern NTSTATUS(NTAPI *NtFlushBuffersFileEx)(
+	_In_ HANDLE FileHandle,
+	_In_ ULONG Flags,
+	_In_reads_bytes_(ParametersSize) PVOID Parameters,
+	_In_ ULONG ParametersSize,
+	_Out_ PIO_STATUS_BLOCK IoStatusBlock);
+
 extern NTSTATUS(NTAPI *NtRemoveIoCompletion)(
 	_In_ HANDLE IoCompletionHandle,
 	_Out_ PVOID *CompletionKey,